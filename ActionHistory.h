@@ -1,16 +1,22 @@
 #ifndef ACTIONHISTORY_H
 #define ACTIONHISTORY_H
 
-#include <stack>
 #include <string>
+#include <vector>
+#include <algorithm>
 #include <iostream>
+#include <cstdio>
+#include <cstdint>
 
 using namespace std;
 
 enum ActionType {
     ADD_ORDER,
     PROCESS_ORDER,
-    DISPATCH_ORDER
+    DISPATCH_ORDER,
+    CANCEL_ORDER,       // priority = priority at cancel time
+    REPRIORITIZE_ORDER, // priority = previous priority
+    ADD_ORDER_BATCH     // orderId = first order, quantity = order count (IDs are consecutive)
 };
 
 struct ActionRecord {
@@ -21,35 +27,212 @@ struct ActionRecord {
     int priority;
 };
 
-// Logs actions and enables Undo functionality using a Stack
+// Logs actions and enables Undo functionality (a stack: last in, first undone).
+//
+// Memory stays flat however long the process runs: the newest records live in a
+// fixed-size ring buffer, and when it fills the oldest half is spilled in one
+// write to an anonymous segment file. A deep undo that empties the ring pages
+// the newest batch back in from disk. An optional depth limit drops the oldest
+// records altogether, which also bounds the file.
 class ActionHistory {
 private:
-    stack<ActionRecord> history;
+    // On-disk layout: five int32 fields per record, oldest first
+    static const size_t FIELDS = 5;
+    static const size_t RECORD_BYTES = FIELDS * sizeof(int32_t);
+
+    vector<ActionRecord> ring;
+    size_t head = 0;  // Oldest record in the ring
+    size_t count = 0;
+
+    // Live spilled records are [diskStart, diskEnd) in record units; anything
+    // before diskStart was dropped by the depth limit
+    FILE* spill = nullptr;
+    size_t diskStart = 0;
+    size_t diskEnd = 0;
+
+    size_t maxDepth;      // 0 = unlimited
+    size_t dropped = 0;   // Records discarded by the depth limit (no longer undoable)
+    size_t spillBatches = 0;
+    size_t pageIns = 0;
+
+    size_t capacity() const { return ring.size(); }
+    size_t batchSize() const { return max<size_t>(1, capacity() / 2); }
+    size_t onDisk() const { return diskEnd - diskStart; }
+
+    ActionRecord& at(size_t i) { return ring[(head + i) % capacity()]; }
+
+    bool writeRecords(size_t position, const vector<int32_t>& fields) {
+        if (fseek(spill, (long)(position * RECORD_BYTES), SEEK_SET) != 0) return false;
+        return fwrite(fields.data(), sizeof(int32_t), fields.size(), spill) == fields.size();
+    }
+
+    bool readRecords(size_t position, size_t n, vector<int32_t>& fields) {
+        fields.resize(n * FIELDS);
+        if (fseek(spill, (long)(position * RECORD_BYTES), SEEK_SET) != 0) return false;
+        return fread(fields.data(), sizeof(int32_t), fields.size(), spill) == fields.size();
+    }
+
+    static void pack(const ActionRecord& r, int32_t* out) {
+        out[0] = r.type;
+        out[1] = r.orderId;
+        out[2] = r.itemId;
+        out[3] = r.quantity;
+        out[4] = r.priority;
+    }
+
+    static ActionRecord unpack(const int32_t* in) {
+        return {(ActionType)in[0], in[1], in[2], in[3], in[4]};
+    }
+
+    // Move the oldest batch from the ring to the end of the segment file.
+    // If the file can't be written, the batch is dropped instead.
+    void spillOldest() {
+        size_t n = min(batchSize(), count);
+        if (!spill) spill = tmpfile();
+
+        vector<int32_t> fields(n * FIELDS);
+        for (size_t i = 0; i < n; ++i) pack(at(i), &fields[i * FIELDS]);
+
+        if (spill && writeRecords(diskEnd, fields)) {
+            diskEnd += n;
+            ++spillBatches;
+        } else {
+            dropped += n;
+        }
+        head = (head + n) % capacity();
+        count -= n;
+    }
+
+    // Bring the newest spilled batch back into the (empty) ring
+    void pageIn() {
+        size_t n = min(batchSize(), onDisk());
+        vector<int32_t> fields;
+        if (!readRecords(diskEnd - n, n, fields)) {
+            // Unreadable segment: nothing older can be undone
+            dropped += onDisk();
+            diskStart = diskEnd = 0;
+            return;
+        }
+        head = 0;
+        for (size_t i = 0; i < n; ++i) ring[i] = unpack(&fields[i * FIELDS]);
+        count = n;
+        diskEnd -= n;
+        ++pageIns;
+        if (diskEnd == diskStart) diskStart = diskEnd = 0;
+    }
+
+    // Slide the live spilled records to the front of the file once the dead
+    // prefix outweighs them, so the file stays within ~2x the live size
+    void compactSpill() {
+        if (diskStart < max(onDisk(), capacity())) return;
+        vector<int32_t> fields;
+        size_t live = onDisk();
+        for (size_t moved = 0; moved < live; moved += batchSize()) {
+            size_t n = min(batchSize(), live - moved);
+            if (!readRecords(diskStart + moved, n, fields) || !writeRecords(moved, fields)) {
+                dropped += onDisk();
+                diskStart = diskEnd = 0;
+                return;
+            }
+        }
+        diskStart = 0;
+        diskEnd = live;
+    }
+
+    void enforceDepth() {
+        if (maxDepth == 0 || size() <= maxDepth) return;
+        size_t excess = size() - maxDepth;
+        dropped += excess;
+
+        size_t fromDisk = min(excess, onDisk());
+        diskStart += fromDisk;
+        excess -= fromDisk;
+        if (diskStart == diskEnd) diskStart = diskEnd = 0;
+        else compactSpill();
+
+        head = (head + excess) % capacity();
+        count -= excess;
+    }
 
 public:
+    explicit ActionHistory(size_t hotCapacity = 4096, size_t depthLimit = 0)
+        : ring(max<size_t>(1, hotCapacity)), maxDepth(depthLimit) {}
+
+    ~ActionHistory() {
+        if (spill) fclose(spill);
+    }
+
+    // Owns the segment file
+    ActionHistory(const ActionHistory&) = delete;
+    ActionHistory& operator=(const ActionHistory&) = delete;
+
     void logAction(ActionRecord record) {
-        history.push(record);
+        if (count == capacity()) spillOldest();
+        at(count) = record;
+        ++count;
+        enforceDepth();
     }
 
     bool hasActions() {
-        return !history.empty();
+        return size() > 0;
     }
 
     ActionRecord popLastAction() {
-        if (!history.empty()) {
-            ActionRecord last = history.top();
-            history.pop();
+        if (count == 0 && onDisk() > 0) pageIn();
+        if (count > 0) {
+            ActionRecord last = at(count - 1);
+            --count;
             return last;
         }
         // Return dummy if empty (caller should check hasActions)
         return {ADD_ORDER, -1, -1, 0, 0};
     }
 
+    // Undoable records, in memory and on disk
+    size_t size() const { return count + onDisk(); }
+
+    // Keep at most 'depth' undoable records (0 = unlimited); trims immediately
+    void setMaxDepth(size_t depth) {
+        maxDepth = depth;
+        enforceDepth();
+    }
+
+    size_t getMaxDepth() const { return maxDepth; }
+    size_t hotCount() const { return count; }
+    size_t hotCapacity() const { return capacity(); }
+    size_t hotBytes() const { return capacity() * sizeof(ActionRecord); }
+    size_t spilledCount() const { return onDisk(); }
+    size_t spillFileBytes() const { return diskEnd * RECORD_BYTES; }
+    size_t droppedCount() const { return dropped; }
+    size_t spillBatchCount() const { return spillBatches; }
+    size_t pageInCount() const { return pageIns; }
+
+    // Oldest first; used for snapshots
+    vector<ActionRecord> getRecords() {
+        vector<ActionRecord> records;
+        records.reserve(size());
+        vector<int32_t> fields;
+        for (size_t pos = diskStart; pos < diskEnd; pos += batchSize()) {
+            size_t n = min(batchSize(), diskEnd - pos);
+            if (!readRecords(pos, n, fields)) break;
+            for (size_t i = 0; i < n; ++i) records.push_back(unpack(&fields[i * FIELDS]));
+        }
+        for (size_t i = 0; i < count; ++i) records.push_back(at(i));
+        return records;
+    }
+
+    void clear() {
+        head = count = 0;
+        diskStart = diskEnd = 0;
+    }
+
     // Peeking for display if needed
     void showHistory() {
         cout << "\n--- Recent Actions (Stack Trace) ---\n";
         // Simplified view
-        cout << "(Stack size: " << history.size() << ")\n";
+        cout << "(Undo depth: " << size() << ", " << count << " in memory, " << onDisk() << " on disk";
+        if (maxDepth > 0) cout << ", limit " << maxDepth;
+        cout << ")\n";
         cout << "------------------------------------\n";
     }
 };
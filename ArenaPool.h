@@ -0,0 +1,65 @@
+#ifndef ARENAPOOL_H
+#define ARENAPOOL_H
+
+#include <vector>
+#include <memory>
+#include <new>
+#include <utility>
+
+using namespace std;
+
+// Bump allocator for many small objects of one type that all live as long as
+// their owner. Objects are carved out of fixed-size blocks (one allocation per
+// block instead of one per object) and destroyed together when the pool goes.
+// Individual objects are never freed, and addresses stay stable.
+template <typename T, size_t BlockSize = 1024>
+class ArenaPool {
+private:
+    struct Slot {
+        alignas(T) unsigned char bytes[sizeof(T)];
+    };
+
+    vector<unique_ptr<Slot[]>> blocks;
+    size_t usedInLast = BlockSize; // Forces a block on first create
+    size_t count = 0;
+
+public:
+    ArenaPool() {}
+    ArenaPool(const ArenaPool&) = delete;
+    ArenaPool& operator=(const ArenaPool&) = delete;
+
+    ~ArenaPool() {
+        clear();
+    }
+
+    template <typename... Args>
+    T* create(Args&&... args) {
+        if (usedInLast == BlockSize) {
+            blocks.emplace_back(new Slot[BlockSize]);
+            usedInLast = 0;
+        }
+        T* obj = new (blocks.back()[usedInLast].bytes) T(std::forward<Args>(args)...);
+        ++usedInLast;
+        ++count;
+        return obj;
+    }
+
+    // Destroy every object and release all blocks
+    void clear() {
+        for (size_t b = 0; b < blocks.size(); ++b) {
+            size_t used = (b + 1 == blocks.size()) ? usedInLast : BlockSize;
+            for (size_t i = 0; i < used; ++i) {
+                reinterpret_cast<T*>(blocks[b][i].bytes)->~T();
+            }
+        }
+        blocks.clear();
+        usedInLast = BlockSize;
+        count = 0;
+    }
+
+    size_t size() const { return count; }
+
+    size_t bytesReserved() const { return blocks.size() * BlockSize * sizeof(T); }
+};
+
+#endif
@@ -0,0 +1,139 @@
+#ifndef BINARYIO_H
+#define BINARYIO_H
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+using namespace std;
+
+// Appends fixed-width values (native byte order) to a growable buffer
+class BinaryWriter {
+public:
+    vector<char> buffer;
+
+    template <typename T>
+    void put(T value) {
+        size_t at = buffer.size();
+        buffer.resize(at + sizeof(T));
+        memcpy(buffer.data() + at, &value, sizeof(T));
+    }
+
+    void putString(const string& s) {
+        put<uint32_t>((uint32_t)s.size());
+        buffer.insert(buffer.end(), s.begin(), s.end());
+    }
+
+    void putBytes(const char* p, size_t n) {
+        buffer.insert(buffer.end(), p, p + n);
+    }
+
+    size_t size() const { return buffer.size(); }
+    void clear() { buffer.clear(); }
+};
+
+// Reads values back from a byte range. Reading past the end sets ok = false
+// and yields zeros, so callers check ok once after a batch of reads.
+class BinaryReader {
+private:
+    const char* pos;
+    const char* end;
+
+public:
+    bool ok = true;
+
+    BinaryReader(const char* data, size_t size) : pos(data), end(data + size) {}
+
+    template <typename T>
+    T get() {
+        T value = T();
+        if ((size_t)(end - pos) < sizeof(T)) {
+            ok = false;
+            pos = end;
+            return value;
+        }
+        memcpy(&value, pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+
+    string getString() {
+        uint32_t n = get<uint32_t>();
+        if (!ok || (size_t)(end - pos) < n) {
+            ok = false;
+            pos = end;
+            return string();
+        }
+        string s(pos, n);
+        pos += n;
+        return s;
+    }
+
+    const char* current() const { return pos; }
+    size_t remaining() const { return (size_t)(end - pos); }
+    void skip(size_t n) { pos += n < remaining() ? n : remaining(); }
+};
+
+// 32-bit FNV-1a, used to detect torn or corrupt records
+inline uint32_t checksum32(const char* data, size_t n) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < n; ++i) {
+        h ^= (unsigned char)data[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Push a stdio stream's data all the way to disk
+inline bool syncFile(FILE* f) {
+    if (fflush(f) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(f)) == 0;
+#else
+    return fsync(fileno(f)) == 0;
+#endif
+}
+
+// Make a rename or create in the file's directory durable (the entry lives in
+// the directory, not the file). Windows has no equivalent; NTFS journals it.
+inline bool syncParentDir(const string& path) {
+#ifdef _WIN32
+    (void)path;
+    return true;
+#else
+    size_t slash = path.find_last_of('/');
+    string dir = slash == string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+    int fd = ::open(dir.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    bool ok = fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+#endif
+}
+
+// Write a file atomically: temp file, sync, rename over the target, sync the directory
+inline bool writeFileAtomic(const string& path, const vector<char>& bytes) {
+    string tmp = path + ".tmp";
+    FILE* f = fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+    bool written = bytes.empty() || fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+    bool synced = syncFile(f);
+    fclose(f);
+    if (!written || !synced) return false;
+#ifdef _WIN32
+    remove(path.c_str()); // rename() does not replace on Windows
+#endif
+    if (rename(tmp.c_str(), path.c_str()) != 0) return false;
+    return syncParentDir(path);
+}
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef CHANGEJOURNAL_H
+#define CHANGEJOURNAL_H
+
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include <mutex>
+#include <chrono>
+
+using namespace std;
+
+// Which part of the warehouse state an entry refers to
+enum EntityKind {
+    PENDING_ORDER,
+    DISPATCHED_ORDER,
+    INVENTORY_ITEM,
+    CATALOG_PRODUCT
+};
+
+struct ChangeEntry {
+    long long version;
+    EntityKind kind;
+    int id;
+};
+
+// Global version counter plus a bounded log of which entities changed.
+// Every mutation bumps the version; clients that remember the version of their
+// last snapshot can ask for just the entities touched since then.
+// Entries only name the entity: the caller reads its current state (or notices
+// it is gone) when building a delta.
+// Recording is guarded by a mutex so a thread-safe InventoryManager can share it.
+//
+// Versions only mean something within one run: after a restart they count
+// again from the restored state, so the same number can name a different
+// state. The epoch (start time in microseconds, small enough for a JS number)
+// tells runs apart; a client whose epoch doesn't match gets the full state.
+class ChangeJournal {
+private:
+    long long version = 0;
+    const long long epoch;
+    deque<ChangeEntry> entries;
+    size_t capacity;
+    mutable mutex lock;
+
+public:
+    ChangeJournal(size_t maxEntries = 4096)
+        : epoch(chrono::duration_cast<chrono::microseconds>(chrono::system_clock::now().time_since_epoch()).count()),
+          capacity(maxEntries > 0 ? maxEntries : 1) {}
+
+    long long currentEpoch() const { return epoch; }
+
+    void record(EntityKind kind, int id) {
+        lock_guard<mutex> lk(lock);
+        ++version;
+        entries.push_back({version, kind, id});
+        if (entries.size() > capacity) entries.pop_front();
+    }
+
+    long long currentVersion() const {
+        lock_guard<mutex> lk(lock);
+        return version;
+    }
+
+    // Entries after 'since', oldest first. Returns false when the journal no
+    // longer reaches back that far (caller should send a full snapshot).
+    bool changesSince(long long since, vector<ChangeEntry>& out) const {
+        lock_guard<mutex> lk(lock);
+        if (since > version) return false;
+        if (since < version && (entries.empty() || entries.front().version > since + 1)) return false;
+
+        for (auto it = entries.rbegin(); it != entries.rend() && it->version > since; ++it) {
+            out.push_back(*it);
+        }
+        reverse(out.begin(), out.end());
+        return true;
+    }
+};
+
+#endif
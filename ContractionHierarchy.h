@@ -0,0 +1,502 @@
+#ifndef CONTRACTIONHIERARCHY_H
+#define CONTRACTIONHIERARCHY_H
+
+#include <vector>
+#include <string>
+#include <queue>
+#include <limits>
+#include <algorithm>
+#include <utility>
+#include <cstdint>
+#include <cstring>
+#include "BinaryIO.h"
+#include "MappedFile.h"
+
+using namespace std;
+
+// Contraction-hierarchy index for point-to-point routes on very large layouts.
+//
+// Built offline from a compiled WarehouseGraph: nodes are contracted one by one
+// (cheapest first), and whenever removing a node would lengthen a shortest path
+// between two of its neighbours a shortcut edge is added in its place. The
+// result is an "upward" graph: each node keeps only the edges to nodes
+// contracted after it. A query runs Dijkstra upwards from both ends and meets
+// near the top of the hierarchy, settling a few hundred nodes instead of a
+// large share of the graph; shortcuts are then unpacked back into the original
+// node sequence.
+//
+// File layout (native byte order, everything 4-byte aligned so the arrays are
+// used straight out of the mapping):
+//   "WHCH0001", uint32 nodes, uint32 edges, uint64 layout fingerprint,
+//   int32 nodeIds[nodes]        dense index -> node ID, ascending
+//   int32 first[nodes + 1]      upward edges of i are [first[i], first[i+1])
+//   int32 target[edges], weight[edges]
+//   int32 middle[edges]         node a shortcut bypasses, -1 for an original edge
+class ContractionHierarchy {
+private:
+    static const size_t HEADER_BYTES = 24;
+    static const size_t WITNESS_SETTLE_LIMIT = 500; // Give up on a witness path after this many nodes
+
+    uint32_t n = 0;
+    uint32_t m = 0;
+    uint64_t layout = 0;
+
+    // Views into either 'storage' (built in-process) or 'file' (loaded)
+    const int32_t* nodeIds = nullptr;
+    const int32_t* first = nullptr;
+    const int32_t* target = nullptr;
+    const int32_t* weight = nullptr;
+    const int32_t* middle = nullptr;
+    vector<int32_t> storage;
+    MappedFile file;
+
+    size_t shortcuts = 0; // Set by build()
+
+    typedef priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> MinQueue;
+
+    void setViews(const int32_t* base) {
+        nodeIds = base;
+        first = nodeIds + n;
+        target = first + n + 1;
+        weight = target + m;
+        middle = weight + m;
+    }
+
+    // --- Preprocessing ---
+
+    struct Arc {
+        int to;
+        int weight;
+        int middle;
+    };
+
+    // Keep only the lightest arc per neighbour
+    static void addArc(vector<Arc>& arcs, int to, int w, int mid) {
+        for (Arc& a : arcs) {
+            if (a.to == to) {
+                if (w < a.weight) {
+                    a.weight = w;
+                    a.middle = mid;
+                }
+                return;
+            }
+        }
+        arcs.push_back({to, w, mid});
+    }
+
+    // Bounded Dijkstra over the not-yet-contracted graph that skips one node,
+    // used to look for a path that makes a shortcut unnecessary
+    struct WitnessSearch {
+        vector<int> dist;
+        vector<unsigned int> stamp;
+        unsigned int current = 0;
+
+        explicit WitnessSearch(size_t nodes) : dist(nodes), stamp(nodes, 0) {}
+
+        int distanceTo(int v) const { return stamp[v] == current ? dist[v] : numeric_limits<int>::max(); }
+
+        void run(const vector<vector<Arc>>& adj, int source, int skip, int limit) {
+            if (++current == 0) {
+                fill(stamp.begin(), stamp.end(), 0);
+                current = 1;
+            }
+            MinQueue pq;
+            dist[source] = 0;
+            stamp[source] = current;
+            pq.push({0, source});
+            size_t settled = 0;
+            while (!pq.empty() && settled < WITNESS_SETTLE_LIMIT) {
+                int d = pq.top().first;
+                int u = pq.top().second;
+                pq.pop();
+                if (d > dist[u]) continue;
+                if (d > limit) break;
+                ++settled;
+                for (const Arc& a : adj[u]) {
+                    if (a.to == skip) continue;
+                    int nd = d + a.weight;
+                    if (stamp[a.to] != current || nd < dist[a.to]) {
+                        stamp[a.to] = current;
+                        dist[a.to] = nd;
+                        pq.push({nd, a.to});
+                    }
+                }
+            }
+        }
+    };
+
+    struct Shortcut {
+        int from, to, weight;
+    };
+
+    // Shortcuts needed to contract v: one per pair of neighbours whose only
+    // short connection runs through v
+    static void findShortcuts(const vector<vector<Arc>>& adj, int v, WitnessSearch& ws, vector<Shortcut>& out) {
+        out.clear();
+        const vector<Arc>& arcs = adj[v];
+        for (size_t i = 0; i + 1 < arcs.size(); ++i) {
+            int maxRest = 0;
+            for (size_t j = i + 1; j < arcs.size(); ++j) maxRest = max(maxRest, arcs[j].weight);
+            ws.run(adj, arcs[i].to, v, arcs[i].weight + maxRest);
+            for (size_t j = i + 1; j < arcs.size(); ++j) {
+                int via = arcs[i].weight + arcs[j].weight;
+                if (ws.distanceTo(arcs[j].to) > via) out.push_back({arcs[i].to, arcs[j].to, via});
+            }
+        }
+    }
+
+    // Edge difference (weighted double), contracted neighbours and level (depth
+    // in the hierarchy so far): cheap nodes go first, contraction spreads
+    // evenly over the layout and the hierarchy stays shallow
+    static int priority(const vector<vector<Arc>>& adj, const vector<int>& contractedNeighbours, const vector<int>& level, int v,
+                        WitnessSearch& ws, vector<Shortcut>& scratch) {
+        findShortcuts(adj, v, ws, scratch);
+        return 2 * ((int)scratch.size() - (int)adj[v].size()) + contractedNeighbours[v] + level[v];
+    }
+
+    // --- Queries ---
+
+    struct QueryScratch {
+        vector<int> dist[2], parentEdge[2], parentNode[2];
+        vector<unsigned int> stamp[2];
+        unsigned int current = 0;
+
+        void begin(size_t nodes) {
+            if (stamp[0].size() < nodes) {
+                for (int d = 0; d < 2; ++d) {
+                    dist[d].resize(nodes);
+                    parentEdge[d].resize(nodes);
+                    parentNode[d].resize(nodes);
+                    stamp[d].assign(nodes, 0);
+                }
+                current = 0;
+            }
+            if (++current == 0) { // Wrapped around
+                for (int d = 0; d < 2; ++d) fill(stamp[d].begin(), stamp[d].end(), 0);
+                current = 1;
+            }
+        }
+    };
+
+    int denseIndex(int node) const {
+        const int32_t* it = lower_bound(nodeIds, nodeIds + n, node);
+        return it != nodeIds + n && *it == node ? (int)(it - nodeIds) : -1;
+    }
+
+    // The edge between 'low' and 'high' lives in the upward list of the one
+    // contracted first; for the two halves of a shortcut that is its middle node
+    int findEdge(int low, int high) const {
+        for (int e = first[low]; e < first[low + 1]; ++e) {
+            if (target[e] == high) return e;
+        }
+        return -1;
+    }
+
+    int middleOf(int low, int high) const {
+        int e = findEdge(low, high);
+        return e == -1 ? -1 : middle[e];
+    }
+
+    // Unpacking only ends if every shortcut splits into two edges from its
+    // middle node and those edges lead upwards: a middle equal to an endpoint,
+    // a missing half or a cycle in the upward graph would loop forever
+    bool shortcutsUnpack() const {
+        for (uint32_t v = 0; v < n; ++v) {
+            for (int e = first[v]; e < first[v + 1]; ++e) {
+                int mid = middle[e];
+                if (mid == -1) continue;
+                if (mid == (int)v || mid == target[e] || findEdge(mid, v) == -1 || findEdge(mid, target[e]) == -1) {
+                    return false;
+                }
+            }
+        }
+        vector<int> indegree(n, 0);
+        for (uint32_t e = 0; e < m; ++e) ++indegree[target[e]];
+        vector<int> ready;
+        for (uint32_t v = 0; v < n; ++v) {
+            if (indegree[v] == 0) ready.push_back((int)v);
+        }
+        size_t ordered = 0;
+        while (!ready.empty()) {
+            int v = ready.back();
+            ready.pop_back();
+            ++ordered;
+            for (int e = first[v]; e < first[v + 1]; ++e) {
+                if (--indegree[target[e]] == 0) ready.push_back(target[e]);
+            }
+        }
+        return ordered == n;
+    }
+
+    struct Segment {
+        int from, to, mid;
+    };
+
+    // Append the original nodes after 'from' along edge from -> to, up to and
+    // including 'to'. 'stack' is scratch, reused across calls.
+    void unpackEdge(int from, int to, int mid, vector<int>& out, vector<Segment>& stack) const {
+        stack.assign(1, {from, to, mid});
+        while (!stack.empty()) {
+            Segment s = stack.back();
+            stack.pop_back();
+            if (s.mid == -1) {
+                out.push_back(nodeIds[s.to]);
+                continue;
+            }
+            // Second half pushed first so the first half unpacks first
+            stack.push_back({s.mid, s.to, middleOf(s.mid, s.to)});
+            stack.push_back({s.from, s.mid, middleOf(s.mid, s.from)});
+        }
+    }
+
+public:
+    ContractionHierarchy() {}
+    ContractionHierarchy(const ContractionHierarchy&) = delete;
+    ContractionHierarchy& operator=(const ContractionHierarchy&) = delete;
+
+    // Identifies the layout an index was built for: FNV-1a over the compiled
+    // graph's arrays (node IDs, CSR offsets, targets, weights)
+    static uint64_t fingerprint(const vector<int>& ids, const vector<int>& start,
+                                const vector<int>& targets, const vector<int>& weights) {
+        uint64_t h = 14695981039346656037ull;
+        auto mix = [&h](const vector<int>& values) {
+            const unsigned char* p = (const unsigned char*)values.data();
+            for (size_t i = 0; i < values.size() * sizeof(int); ++i) {
+                h ^= p[i];
+                h *= 1099511628211ull;
+            }
+            h ^= values.size();
+            h *= 1099511628211ull;
+        };
+        mix(ids);
+        mix(start);
+        mix(targets);
+        mix(weights);
+        return h;
+    }
+
+    // Contract a compiled graph given as CSR arrays (see WarehouseGraph::buildHierarchy)
+    void build(const vector<int>& ids, const vector<int>& start, const vector<int>& targets, const vector<int>& weights) {
+        file.close();
+        n = (uint32_t)ids.size();
+        layout = fingerprint(ids, start, targets, weights);
+
+        vector<vector<Arc>> adj(n);
+        for (uint32_t u = 0; u < n; ++u) {
+            for (int e = start[u]; e < start[u + 1]; ++e) {
+                if (targets[e] != (int)u) addArc(adj[u], targets[e], weights[e], -1);
+            }
+        }
+
+        vector<vector<Arc>> up(n);
+        vector<int> contractedNeighbours(n, 0);
+        vector<int> level(n, 0);
+        vector<char> contracted(n, 0);
+        WitnessSearch ws(n);
+        vector<Shortcut> found;
+
+        MinQueue order;
+        for (uint32_t v = 0; v < n; ++v) order.push({priority(adj, contractedNeighbours, level, v, ws, found), (int)v});
+
+        shortcuts = 0;
+        while (!order.empty()) {
+            int v = order.top().second;
+            order.pop();
+            if (contracted[v]) continue;
+
+            // Lazy update: neighbours contracted since v was queued may have made it dearer
+            int p = priority(adj, contractedNeighbours, level, v, ws, found);
+            if (!order.empty() && p > order.top().first) {
+                order.push({p, v});
+                continue;
+            }
+
+            // 'found' holds v's shortcuts from the priority computation
+            up[v] = adj[v];
+            for (const Arc& a : adj[v]) {
+                vector<Arc>& back = adj[a.to];
+                for (size_t i = 0; i < back.size(); ++i) {
+                    if (back[i].to == v) {
+                        back[i] = back.back();
+                        back.pop_back();
+                        break;
+                    }
+                }
+                ++contractedNeighbours[a.to];
+                level[a.to] = max(level[a.to], level[v] + 1);
+            }
+            for (const Shortcut& s : found) {
+                addArc(adj[s.from], s.to, s.weight, v);
+                addArc(adj[s.to], s.from, s.weight, v);
+            }
+            shortcuts += found.size();
+            adj[v].clear();
+            adj[v].shrink_to_fit();
+            contracted[v] = 1;
+        }
+
+        m = 0;
+        for (const vector<Arc>& arcs : up) m += (uint32_t)arcs.size();
+        storage.assign((size_t)n + (n + 1) + 3 * (size_t)m, 0);
+        setViews(storage.data());
+
+        int32_t* ids32 = storage.data();
+        int32_t* first32 = ids32 + n;
+        int32_t* target32 = first32 + n + 1;
+        int32_t* weight32 = target32 + m;
+        int32_t* middle32 = weight32 + m;
+        uint32_t e = 0;
+        for (uint32_t v = 0; v < n; ++v) {
+            ids32[v] = ids[v];
+            first32[v] = (int32_t)e;
+            for (const Arc& a : up[v]) {
+                target32[e] = a.to;
+                weight32[e] = a.weight;
+                middle32[e] = a.middle;
+                ++e;
+            }
+        }
+        first32[n] = (int32_t)e;
+    }
+
+    bool save(const string& path) const {
+        BinaryWriter w;
+        w.putBytes("WHCH0001", 8);
+        w.put<uint32_t>(n);
+        w.put<uint32_t>(m);
+        w.put<uint64_t>(layout);
+        w.putBytes((const char*)nodeIds, (size_t)n * sizeof(int32_t));
+        w.putBytes((const char*)first, (size_t)(n + 1) * sizeof(int32_t));
+        w.putBytes((const char*)target, (size_t)m * sizeof(int32_t));
+        w.putBytes((const char*)weight, (size_t)m * sizeof(int32_t));
+        w.putBytes((const char*)middle, (size_t)m * sizeof(int32_t));
+        return writeFileAtomic(path, w.buffer);
+    }
+
+    // Map an index file. Structure is checked up front so a damaged file is
+    // rejected instead of sending queries out of bounds.
+    bool open(const string& path) {
+        storage.clear();
+        n = m = 0;
+        nodeIds = first = target = weight = middle = nullptr;
+        if (!file.open(path) || file.size() < HEADER_BYTES || memcmp(file.data(), "WHCH0001", 8) != 0) {
+            file.close();
+            return false;
+        }
+        BinaryReader r(file.data() + 8, HEADER_BYTES - 8);
+        uint32_t nodes = r.get<uint32_t>();
+        uint32_t edges = r.get<uint32_t>();
+        uint64_t fp = r.get<uint64_t>();
+        if (file.size() != HEADER_BYTES + ((size_t)nodes * 2 + 1 + (size_t)edges * 3) * sizeof(int32_t)) {
+            file.close();
+            return false;
+        }
+
+        n = nodes;
+        m = edges;
+        layout = fp;
+        setViews((const int32_t*)(file.data() + HEADER_BYTES));
+
+        bool ok = first[0] == 0 && first[n] == (int32_t)m;
+        for (uint32_t v = 0; ok && v < n; ++v) {
+            ok = first[v] <= first[v + 1] && (v == 0 || nodeIds[v - 1] < nodeIds[v]);
+        }
+        for (uint32_t e = 0; ok && e < m; ++e) {
+            ok = target[e] >= 0 && (uint32_t)target[e] < n && weight[e] >= 0 &&
+                 middle[e] >= -1 && middle[e] < (int32_t)n;
+        }
+        ok = ok && shortcutsUnpack();
+        if (!ok) {
+            file.close();
+            n = m = 0;
+            nodeIds = first = target = weight = middle = nullptr;
+        }
+        return ok;
+    }
+
+    bool empty() const { return n == 0; }
+    size_t nodeCount() const { return n; }
+    size_t edgeCount() const { return m; }
+    size_t shortcutCount() const { return shortcuts; }
+    uint64_t layoutFingerprint() const { return layout; }
+    bool isMapped() const { return file.isMapped(); }
+
+    // Bidirectional upward Dijkstra. Same result contract as
+    // WarehouseGraph::getShortestPath: {distance, node IDs start..end}, or
+    // {-1, {}} if unreachable. Read-only with per-thread scratch, so it is safe
+    // to call from several threads. 'settled' receives the nodes settled by
+    // both searches together.
+    pair<int, vector<int>> query(int start, int end, size_t* settled = nullptr) const {
+        vector<int> path;
+        if (settled) *settled = 0;
+        if (start == end) {
+            path.push_back(start);
+            return {0, path};
+        }
+        int s = denseIndex(start), t = denseIndex(end);
+        if (s == -1 || t == -1) return {-1, path};
+
+        thread_local QueryScratch sc;
+        sc.begin(n);
+        MinQueue pq[2];
+        int roots[2] = {s, t};
+        for (int d = 0; d < 2; ++d) {
+            sc.dist[d][roots[d]] = 0;
+            sc.parentNode[d][roots[d]] = -1;
+            sc.stamp[d][roots[d]] = sc.current;
+            pq[d].push({0, roots[d]});
+        }
+
+        int best = numeric_limits<int>::max(), meet = -1;
+        size_t settledCount = 0;
+        // A direction stops once its next node can't beat the best meeting so far
+        while ((!pq[0].empty() && pq[0].top().first < best) || (!pq[1].empty() && pq[1].top().first < best)) {
+            for (int d = 0; d < 2; ++d) {
+                if (pq[d].empty() || pq[d].top().first >= best) continue;
+                int du = pq[d].top().first;
+                int u = pq[d].top().second;
+                pq[d].pop();
+                if (du > sc.dist[d][u]) continue;
+                ++settledCount;
+
+                if (sc.stamp[1 - d][u] == sc.current && du + sc.dist[1 - d][u] < best) {
+                    best = du + sc.dist[1 - d][u];
+                    meet = u;
+                }
+                for (int e = first[u]; e < first[u + 1]; ++e) {
+                    int v = target[e];
+                    int nd = du + weight[e];
+                    if (sc.stamp[d][v] != sc.current || nd < sc.dist[d][v]) {
+                        sc.stamp[d][v] = sc.current;
+                        sc.dist[d][v] = nd;
+                        sc.parentNode[d][v] = u;
+                        sc.parentEdge[d][v] = e;
+                        pq[d].push({nd, v});
+                    }
+                }
+            }
+        }
+        if (settled) *settled = settledCount;
+        if (meet == -1) return {-1, path};
+
+        // start -> meet: walk the forward parents back, then unpack in order
+        vector<Segment> segments;
+        vector<int> upChain;
+        for (int v = meet; v != s; v = sc.parentNode[0][v]) upChain.push_back(v);
+        path.push_back(start);
+        int from = s;
+        for (size_t i = upChain.size(); i-- > 0;) {
+            int v = upChain[i];
+            unpackEdge(from, v, middle[sc.parentEdge[0][v]], path, segments);
+            from = v;
+        }
+        // meet -> end: the backward parents already run downwards
+        for (int v = meet; v != t; v = sc.parentNode[1][v]) {
+            int next = sc.parentNode[1][v];
+            unpackEdge(v, next, middle[sc.parentEdge[1][v]], path, segments);
+        }
+        return {best, path};
+    }
+};
+
+#endif
@@ -0,0 +1,229 @@
+#ifndef DATALOADER_H
+#define DATALOADER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <charconv>
+#include <iostream>
+#include "MappedFile.h"
+#include "WarehouseGraph.h"
+#include "InventoryManager.h"
+#include "ProductCatalog.h"
+
+using namespace std;
+
+// Bulk loaders for site data files. Each file is memory-mapped, split into
+// newline-aligned chunks that are parsed on separate threads straight out of
+// the mapping, and the results handed to the structure's bulk insert.
+//
+// Formats (one record per line; blank lines, '#' comments and a header row are skipped):
+//   layout:     u v weight           (whitespace or comma separated)
+//   inventory:  id,name,qty,location  (repeat an id to stock it in more bins)
+//   catalog:    id,name,category,price
+// CSV fields may be double-quoted to contain commas (no escaped quotes inside).
+
+struct LoadReport {
+    string what;
+    size_t bytes = 0;
+    size_t records = 0;
+    size_t skipped = 0;  // Malformed lines
+    size_t threads = 0;
+    double ms = 0;
+
+    double mbPerSec() const { return ms > 0 ? (bytes / 1048576.0) / (ms / 1000.0) : 0; }
+    double recordsPerSec() const { return ms > 0 ? records / (ms / 1000.0) : 0; }
+};
+
+inline void printLoadReport(const LoadReport& r, ostream& out) {
+    out << "Loaded " << r.records << " " << r.what << " records (" << r.bytes / 1024 << " KB, "
+        << r.skipped << " skipped) in " << r.ms << " ms on " << r.threads << " threads: "
+        << r.mbPerSec() << " MB/s, " << (size_t)r.recordsPerSec() << " records/s" << endl;
+}
+
+// Zero-copy field splitter over one line
+class FieldCursor {
+private:
+    const char* p;
+    const char* end;
+
+    static bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+public:
+    FieldCursor(const char* begin, const char* finish) : p(begin), end(finish) {}
+
+    // Next field up to 'sep' (or any whitespace run when sep is ' '), trimmed
+    bool next(string_view& field, char sep) {
+        while (p < end && (isBlank(*p) || (sep == ' ' && *p == ','))) ++p;
+        if (p >= end) return false;
+
+        const char* start = p;
+        if (*p == '"' && sep != ' ') {
+            ++start;
+            const char* close = start;
+            while (close < end && *close != '"') ++close;
+            field = string_view(start, close - start);
+            p = close < end ? close + 1 : end;
+            while (p < end && *p != sep) ++p;
+        } else {
+            while (p < end && *p != sep && !(sep == ' ' && (isBlank(*p) || *p == ','))) ++p;
+            const char* stop = p;
+            while (stop > start && isBlank(stop[-1])) --stop;
+            field = string_view(start, stop - start);
+        }
+        if (p < end) ++p; // Consume the separator
+        return true;
+    }
+};
+
+inline bool parseInt(string_view s, int& value) {
+    auto res = from_chars(s.data(), s.data() + s.size(), value);
+    return res.ec == errc() && res.ptr == s.data() + s.size();
+}
+
+inline bool parseDouble(string_view s, double& value) {
+    auto res = from_chars(s.data(), s.data() + s.size(), value);
+    return res.ec == errc() && res.ptr == s.data() + s.size();
+}
+
+// Files below this are parsed on one thread; spawning isn't worth it
+static const size_t MIN_CHUNK_BYTES = 1 << 20;
+
+// Split [data, data+size) into newline-aligned chunks, run parseLine(begin, end, record)
+// over every line of each chunk in parallel, and concatenate the records in file order.
+// A first record line that fails to parse is taken as a header, not counted as skipped.
+template <typename Record, typename ParseLine>
+vector<Record> parseChunked(const char* data, size_t size, ParseLine parseLine, LoadReport& report) {
+    size_t threads = max<size_t>(1, thread::hardware_concurrency());
+    threads = max<size_t>(1, min(threads, size / MIN_CHUNK_BYTES));
+
+    vector<const char*> bounds(1, data);
+    for (size_t i = 1; i < threads; ++i) {
+        const char* cut = data + size * i / threads;
+        if (cut < bounds.back()) cut = bounds.back();
+        while (cut < data + size && *cut != '\n') ++cut;
+        if (cut < data + size) ++cut;
+        bounds.push_back(cut);
+    }
+    bounds.push_back(data + size);
+
+    vector<vector<Record>> parts(threads);
+    vector<size_t> bad(threads, 0);
+    auto work = [&](size_t t) {
+        const char* p = bounds[t];
+        const char* chunkEnd = bounds[t + 1];
+        parts[t].reserve((chunkEnd - p) / 24);
+        bool maybeHeader = (t == 0);
+        while (p < chunkEnd) {
+            const char* eol = p;
+            while (eol < chunkEnd && *eol != '\n') ++eol;
+
+            const char* first = p;
+            while (first < eol && (*first == ' ' || *first == '\t' || *first == '\r')) ++first;
+            if (first < eol && *first != '#') {
+                Record rec;
+                if (parseLine(first, eol, rec)) {
+                    parts[t].push_back(std::move(rec));
+                } else if (!maybeHeader) {
+                    ++bad[t];
+                }
+                maybeHeader = false;
+            }
+            p = eol + 1;
+        }
+    };
+
+    vector<thread> pool;
+    for (size_t t = 1; t < threads; ++t) pool.emplace_back(work, t);
+    work(0);
+    for (thread& th : pool) th.join();
+
+    size_t total = 0;
+    for (auto& part : parts) total += part.size();
+    vector<Record> records;
+    records.reserve(total);
+    for (size_t t = 0; t < threads; ++t) {
+        for (Record& rec : parts[t]) records.push_back(std::move(rec));
+        report.skipped += bad[t];
+    }
+    report.threads = threads;
+    return records;
+}
+
+inline double elapsedMs(chrono::steady_clock::time_point since) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - since).count();
+}
+
+// Edge list -> graph (compiled afterwards, like the built-in layout)
+inline bool loadLayoutFile(const string& path, WarehouseGraph& graph, LoadReport& report) {
+    auto start = chrono::steady_clock::now();
+    MappedFile file;
+    if (!file.open(path)) return false;
+
+    report.what = "layout";
+    report.bytes = file.size();
+    vector<GraphEdge> edges = parseChunked<GraphEdge>(file.data(), file.size(),
+        [](const char* b, const char* e, GraphEdge& edge) {
+            FieldCursor f(b, e);
+            string_view u, v, w;
+            return f.next(u, ' ') && f.next(v, ' ') && f.next(w, ' ') &&
+                   parseInt(u, edge.u) && parseInt(v, edge.v) && parseInt(w, edge.weight) &&
+                   edge.weight >= 0;
+        }, report);
+
+    graph.addEdges(edges);
+    graph.compile();
+    report.records = edges.size();
+    report.ms = elapsedMs(start);
+    return true;
+}
+
+inline bool loadInventoryFile(const string& path, InventoryManager& inv, LoadReport& report) {
+    auto start = chrono::steady_clock::now();
+    MappedFile file;
+    if (!file.open(path)) return false;
+
+    report.what = "inventory";
+    report.bytes = file.size();
+    vector<Item> items = parseChunked<Item>(file.data(), file.size(),
+        [](const char* b, const char* e, Item& item) {
+            FieldCursor f(b, e);
+            string_view id, name, qty, loc;
+            if (!(f.next(id, ',') && f.next(name, ',') && f.next(qty, ',') && f.next(loc, ','))) return false;
+            if (!(parseInt(id, item.id) && parseInt(qty, item.quantity) && parseInt(loc, item.locationNode))) return false;
+            item.name.assign(name.data(), name.size());
+            item.bins.assign(1, {item.locationNode, item.quantity});
+            return true;
+        }, report);
+
+    inv.addItems(items);
+    report.records = items.size();
+    report.ms = elapsedMs(start);
+    return true;
+}
+
+inline bool loadCatalogFile(const string& path, ProductCatalog& cat, LoadReport& report) {
+    auto start = chrono::steady_clock::now();
+    MappedFile file;
+    if (!file.open(path)) return false;
+
+    report.what = "catalog";
+    report.bytes = file.size();
+    // Names and categories stay views into the mapping until the catalog copies them
+    vector<ProductRecord> products = parseChunked<ProductRecord>(file.data(), file.size(),
+        [](const char* b, const char* e, ProductRecord& p) {
+            FieldCursor f(b, e);
+            string_view id, price;
+            return f.next(id, ',') && f.next(p.name, ',') && f.next(p.category, ',') && f.next(price, ',') &&
+                   parseInt(id, p.id) && parseDouble(price, p.price);
+        }, report);
+
+    cat.addProducts(products);
+    report.records = products.size();
+    report.ms = elapsedMs(start);
+    return true;
+}
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef FLATHASHMAP_H
+#define FLATHASHMAP_H
+
+#include <vector>
+#include <cstdint>
+#include <utility>
+
+using namespace std;
+
+// Open-addressing hash table with int keys and Robin Hood probing.
+// Keys and probe distances sit in one flat array (the part scanned while
+// probing), values in a parallel array, so a lookup touches one or two cache
+// lines instead of chasing bucket-list nodes.
+//
+// Note: like std::vector, growing the table moves the values; pointers
+// returned by find/insert are only valid until the next insert.
+template <typename V>
+class FlatHashMap {
+private:
+    struct Meta {
+        int key;
+        int dist; // Distance from the home slot, -1 = empty
+    };
+
+    vector<Meta> meta;
+    vector<V> values;
+    size_t count = 0;
+    size_t mask = 0;
+
+    static size_t hashKey(int key) {
+        // Fibonacci hashing spreads sequential IDs across the table;
+        // fold the high half down because the mask keeps only low bits
+        uint64_t h = (uint64_t)(uint32_t)key * 0x9E3779B97F4A7C15ull;
+        return (size_t)(h ^ (h >> 32));
+    }
+
+    void rehash(size_t newCapacity) {
+        vector<Meta> oldMeta;
+        vector<V> oldValues;
+        oldMeta.swap(meta);
+        oldValues.swap(values);
+
+        meta.assign(newCapacity, {0, -1});
+        values.clear();
+        values.resize(newCapacity);
+        mask = newCapacity - 1;
+        count = 0;
+
+        for (size_t i = 0; i < oldMeta.size(); ++i) {
+            if (oldMeta[i].dist >= 0) insert(oldMeta[i].key, std::move(oldValues[i]));
+        }
+    }
+
+    // Keep the load factor under 7/8
+    void growIfNeeded() {
+        if (meta.empty()) rehash(16);
+        else if ((count + 1) * 8 > meta.size() * 7) rehash(meta.size() * 2);
+    }
+
+public:
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    size_t capacity() const { return meta.size(); }
+
+    // Size the table for n entries up front (bulk loads)
+    void reserve(size_t n) {
+        size_t needed = 16;
+        while (needed * 7 < n * 8) needed *= 2;
+        if (needed > meta.size()) rehash(needed);
+    }
+
+    // Single probe sequence; nullptr if absent
+    V* find(int key) {
+        if (count == 0) return nullptr;
+        size_t i = hashKey(key) & mask;
+        for (int d = 0; meta[i].dist >= d; ++d) {
+            if (meta[i].key == key) return &values[i];
+            i = (i + 1) & mask;
+        }
+        return nullptr;
+    }
+
+    const V* find(int key) const {
+        return const_cast<FlatHashMap*>(this)->find(key);
+    }
+
+    // Insert or overwrite; returns the stored value
+    V* insert(int key, V value) {
+        V* existing = find(key);
+        if (existing) {
+            *existing = std::move(value);
+            return existing;
+        }
+        growIfNeeded();
+
+        Meta entry = {key, 0};
+        size_t i = hashKey(key) & mask;
+        V* placed = nullptr;
+        while (true) {
+            if (meta[i].dist < 0) {
+                meta[i] = entry;
+                values[i] = std::move(value);
+                ++count;
+                return placed ? placed : &values[i];
+            }
+            // Robin Hood: the entry further from home takes the slot
+            if (meta[i].dist < entry.dist) {
+                swap(meta[i], entry);
+                swap(values[i], value);
+                if (!placed) placed = &values[i];
+            }
+            ++entry.dist;
+            i = (i + 1) & mask;
+        }
+    }
+
+    // Visit every (key, value) pair in table order
+    template <typename F>
+    void forEach(F f) {
+        for (size_t i = 0; i < meta.size(); ++i) {
+            if (meta[i].dist >= 0) f(meta[i].key, values[i]);
+        }
+    }
+
+    template <typename F>
+    void forEach(F f) const {
+        for (size_t i = 0; i < meta.size(); ++i) {
+            if (meta[i].dist >= 0) f(meta[i].key, values[i]);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,210 @@
+#ifndef FRAMEDPROTOCOL_H
+#define FRAMEDPROTOCOL_H
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <cstdio>
+#include <streambuf>
+#include <ostream>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// Length-prefixed framing for API mode (--api --binary), so a client can keep
+// many commands in flight on one pipe. Every frame, both directions:
+//
+//   uint32 payloadLength | uint32 requestId | payload
+//
+// Integers are little-endian. Request payloads are command lines (no newline);
+// response payloads are the command's JSON, tagged with the request's id.
+// Responses come back in request order. The ready signal is frame id 0.
+
+static const size_t FRAME_HEADER_BYTES = 8;
+static const uint32_t MAX_FRAME_PAYLOAD = 1 << 20;
+
+inline uint32_t readLE32(const char* p) {
+    const unsigned char* b = (const unsigned char*)p;
+    return (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24);
+}
+
+inline void writeLE32(char* p, uint32_t v) {
+    p[0] = (char)(v & 0xff);
+    p[1] = (char)((v >> 8) & 0xff);
+    p[2] = (char)((v >> 16) & 0xff);
+    p[3] = (char)((v >> 24) & 0xff);
+}
+
+// Raw, unbuffered read/write on a file descriptor; retries on EINTR
+inline long readFd(int fd, char* buf, size_t n) {
+    while (true) {
+#ifdef _WIN32
+        long got = _read(fd, buf, (unsigned)n);
+#else
+        long got = (long)read(fd, buf, n);
+#endif
+        if (got >= 0 || errno != EINTR) return got;
+    }
+}
+
+inline bool writeFd(int fd, const char* buf, size_t n) {
+    while (n > 0) {
+#ifdef _WIN32
+        long put = _write(fd, buf, (unsigned)n);
+#else
+        long put = (long)write(fd, buf, n);
+#endif
+        if (put < 0 && errno == EINTR) continue;
+        if (put <= 0) return false;
+        buf += put;
+        n -= (size_t)put;
+    }
+    return true;
+}
+
+// Pulls request frames off a descriptor. fill() blocks until some bytes
+// arrive; next() then hands out every complete frame buffered so far.
+class FrameReader {
+private:
+    int fd;
+    vector<char> buffer;
+    size_t start = 0;   // First unconsumed byte
+    size_t end = 0;     // One past the last byte read
+
+public:
+    explicit FrameReader(int fd_, size_t capacity = 64 * 1024) : fd(fd_), buffer(capacity) {
+#ifdef _WIN32
+        _setmode(fd, _O_BINARY);
+#endif
+    }
+
+    // False on end of input or a read error
+    bool fill() {
+        if (start == end) {
+            start = end = 0;
+        } else if (end == buffer.size()) {
+            // Slide the partial frame to the front; grow only if it alone fills the buffer
+            memmove(buffer.data(), buffer.data() + start, end - start);
+            end -= start;
+            start = 0;
+            if (end == buffer.size()) buffer.resize(buffer.size() * 2);
+        }
+        long got = readFd(fd, buffer.data() + end, buffer.size() - end);
+        if (got <= 0) return false;
+        end += (size_t)got;
+        return true;
+    }
+
+    // Next complete frame, if any. A frame larger than MAX_FRAME_PAYLOAD is
+    // still consumed (once all of it has arrived) but flagged 'oversized'
+    // with an empty payload, so the stream stays in sync.
+    bool next(uint32_t& id, string& payload, bool& oversized) {
+        if (end - start < FRAME_HEADER_BYTES) return false;
+        uint32_t length = readLE32(buffer.data() + start);
+        if (end - start - FRAME_HEADER_BYTES < length) {
+            // Make sure the whole frame will fit once the rest arrives
+            size_t need = FRAME_HEADER_BYTES + (size_t)length;
+            if (need > buffer.size() && length <= MAX_FRAME_PAYLOAD) buffer.resize(need);
+            if (length > MAX_FRAME_PAYLOAD) {
+                // Drop what we have of it and skip the rest as it comes
+                return skipOversized(id, length, oversized);
+            }
+            return false;
+        }
+        id = readLE32(buffer.data() + start + 4);
+        oversized = length > MAX_FRAME_PAYLOAD;
+        if (oversized) payload.clear();
+        else payload.assign(buffer.data() + start + FRAME_HEADER_BYTES, length);
+        start += FRAME_HEADER_BYTES + length;
+        return true;
+    }
+
+private:
+    // Consume an oversized frame by reading past it in buffer-sized chunks
+    bool skipOversized(uint32_t& id, uint32_t length, bool& oversized) {
+        id = readLE32(buffer.data() + start + 4);
+        size_t remaining = FRAME_HEADER_BYTES + (size_t)length - (end - start);
+        start = end = 0;
+        while (remaining > 0) {
+            long got = readFd(fd, buffer.data(), buffer.size() < remaining ? buffer.size() : remaining);
+            if (got <= 0) return false;
+            remaining -= (size_t)got;
+        }
+        oversized = true;
+        return true;
+    }
+};
+
+// Collects response frames in one reusable buffer. Commands write into it
+// through stream() (point apiOut() at it); endl there costs nothing, the
+// whole batch goes out in a single write on flushTo().
+class FrameWriter : private streambuf {
+private:
+    vector<char> buffer;
+    size_t frameStart = 0;
+    ostream out;
+
+    int overflow(int c) override {
+        if (c != EOF) buffer.push_back((char)c);
+        return c;
+    }
+
+    streamsize xsputn(const char* s, streamsize n) override {
+        buffer.insert(buffer.end(), s, s + n);
+        return n;
+    }
+
+    int sync() override { return 0; } // endl flushes per line; the batch flushes once
+
+public:
+    FrameWriter() : out(this) {
+        buffer.reserve(64 * 1024);
+    }
+
+    FrameWriter(const FrameWriter&) = delete;
+    FrameWriter& operator=(const FrameWriter&) = delete;
+
+    ostream& stream() { return out; }
+
+    // Start a response: header now, length patched in by endFrame()
+    void beginFrame(uint32_t id) {
+        frameStart = buffer.size();
+        buffer.resize(frameStart + FRAME_HEADER_BYTES);
+        writeLE32(buffer.data() + frameStart + 4, id);
+    }
+
+    // Close the response; trailing newlines from endl are dropped
+    void endFrame() {
+        while (buffer.size() > frameStart + FRAME_HEADER_BYTES && buffer.back() == '\n') buffer.pop_back();
+        if (buffer.size() == frameStart + FRAME_HEADER_BYTES) {
+            buffer.push_back('{');
+            buffer.push_back('}');
+        }
+        writeLE32(buffer.data() + frameStart, (uint32_t)(buffer.size() - frameStart - FRAME_HEADER_BYTES));
+    }
+
+    void writeFrame(uint32_t id, const string& payload) {
+        beginFrame(id);
+        buffer.insert(buffer.end(), payload.begin(), payload.end());
+        endFrame();
+    }
+
+    size_t pending() const { return buffer.size(); }
+
+    // Everything buffered, in one write; keeps the capacity for the next batch
+    bool flushTo(int fd) {
+        bool ok = buffer.empty() || writeFd(fd, buffer.data(), buffer.size());
+        buffer.clear();
+        return ok;
+    }
+};
+
+#endif
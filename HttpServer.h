@@ -0,0 +1,511 @@
+#ifndef HTTPSERVER_H
+#define HTTPSERVER_H
+
+// Minimal HTTP/1.1 server for --http mode (Linux only: epoll + eventfd).
+//
+// One event-loop thread owns every socket: it accepts, reads, parses and
+// writes without ever blocking. Parsed requests go to a pool of worker
+// threads that run the handler; finished responses come back through a
+// completion list and an eventfd wake-up. Connections are keep-alive and may
+// pipeline, but each has at most one request in flight, so responses always
+// leave in request order. How far handlers may overlap is up to the handler
+// (main.cpp takes a shared lock for reads, an exclusive one for writes).
+#ifdef __linux__
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+struct HttpRequest {
+    string method;
+    string path;   // Without the query string
+    string query;  // After '?', undecoded
+    string body;
+    bool keepAlive = true;
+
+    // Value of ?name=... (undecoded), or "" if absent
+    string queryParam(const string& name) const {
+        size_t pos = 0;
+        while (pos <= query.size()) {
+            size_t amp = query.find('&', pos);
+            if (amp == string::npos) amp = query.size();
+            size_t eq = query.find('=', pos);
+            if (eq != string::npos && eq < amp && query.compare(pos, eq - pos, name) == 0 && eq - pos == name.size()) {
+                return query.substr(eq + 1, amp - eq - 1);
+            }
+            pos = amp + 1;
+        }
+        return "";
+    }
+};
+
+struct HttpResponse {
+    int status = 200;
+    string contentType = "application/json";
+    string body;
+};
+
+class HttpServer {
+public:
+    typedef function<void(const HttpRequest&, HttpResponse&)> Handler;
+
+private:
+    static const size_t MAX_HEADER_BYTES = 64 * 1024;
+    static const size_t MAX_BODY_BYTES = 1 << 20;
+    static const size_t READ_CHUNK = 16 * 1024;
+    // Input buffered per connection before reads pause: room for one request of
+    // the largest allowed size, pipelined ones wait in the socket
+    static const size_t MAX_BUFFERED_INPUT = MAX_HEADER_BYTES + 4 + MAX_BODY_BYTES;
+
+    struct Connection {
+        int fd;
+        uint64_t id;             // Never reused, unlike fds
+        string in;
+        string out;
+        size_t outPos = 0;
+        bool busy = false;       // A request is with the workers
+        bool closeAfterWrite = false;
+        bool sentContinue = false;
+        bool wantWrite = false;      // Output is waiting for the socket
+        bool readPaused = false;     // 'in' is full until the workers catch up
+        bool peerClosed = false;     // Client shut down its side; answer what it sent, then close
+        uint32_t events = EPOLLIN | EPOLLRDHUP; // Registered with epoll
+    };
+
+    struct Job {
+        int fd;
+        uint64_t id;
+        HttpRequest request;
+    };
+
+    struct Done {
+        int fd;
+        uint64_t id;
+        string bytes;
+        bool close;
+    };
+
+    enum ParseResult { PARSE_INCOMPLETE, PARSE_OK, PARSE_BAD, PARSE_TOO_LARGE, PARSE_UNSUPPORTED };
+
+    Handler handler;
+    size_t workerCount;
+    int listenFd = -1;
+    int epollFd = -1;
+    int wakeFd = -1;
+    atomic<bool> stopRequested{false};
+
+    unordered_map<int, Connection> connections;
+    uint64_t nextId = 1;
+
+    vector<thread> workers;
+    mutex jobsLock;
+    condition_variable jobsReady;
+    deque<Job> jobs;
+    bool workersStopping = false;
+
+    mutex doneLock;
+    vector<Done> done;
+
+    static bool setNonBlocking(int fd) {
+        int flags = fcntl(fd, F_GETFL, 0);
+        return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+    }
+
+    static bool iequals(const string& a, const char* b) {
+        size_t n = strlen(b);
+        if (a.size() != n) return false;
+        for (size_t i = 0; i < n; ++i) {
+            if (tolower((unsigned char)a[i]) != tolower((unsigned char)b[i])) return false;
+        }
+        return true;
+    }
+
+    static string trim(const string& s) {
+        size_t b = s.find_first_not_of(" \t");
+        if (b == string::npos) return "";
+        size_t e = s.find_last_not_of(" \t");
+        return s.substr(b, e - b + 1);
+    }
+
+    // Parse one request from the front of 'buf'. On PARSE_OK, 'consumed' is its
+    // length in bytes. 'expectContinue' is set if the client waits for a
+    // 100 Continue before sending the body.
+    static ParseResult parseRequest(const string& buf, HttpRequest& req, size_t& consumed, bool& expectContinue) {
+        expectContinue = false;
+        size_t headerEnd = buf.find("\r\n\r\n");
+        if (headerEnd == string::npos) return buf.size() > MAX_HEADER_BYTES ? PARSE_TOO_LARGE : PARSE_INCOMPLETE;
+        if (headerEnd > MAX_HEADER_BYTES) return PARSE_TOO_LARGE;
+
+        size_t lineEnd = buf.find("\r\n");
+        string requestLine = buf.substr(0, lineEnd);
+        size_t sp1 = requestLine.find(' ');
+        size_t sp2 = sp1 == string::npos ? string::npos : requestLine.find(' ', sp1 + 1);
+        if (sp2 == string::npos) return PARSE_BAD;
+        req.method = requestLine.substr(0, sp1);
+        string target = requestLine.substr(sp1 + 1, sp2 - sp1 - 1);
+        string version = requestLine.substr(sp2 + 1);
+        if (version != "HTTP/1.1" && version != "HTTP/1.0") return PARSE_BAD;
+
+        size_t q = target.find('?');
+        req.path = target.substr(0, q);
+        req.query = q == string::npos ? "" : target.substr(q + 1);
+        req.keepAlive = version == "HTTP/1.1";
+
+        size_t contentLength = 0;
+        size_t pos = lineEnd + 2;
+        while (pos < headerEnd) {
+            size_t end = buf.find("\r\n", pos);
+            string line = buf.substr(pos, end - pos);
+            pos = end + 2;
+            size_t colon = line.find(':');
+            if (colon == string::npos) return PARSE_BAD;
+            string name = line.substr(0, colon);
+            string value = trim(line.substr(colon + 1));
+            if (iequals(name, "Content-Length")) {
+                char* endp = nullptr;
+                unsigned long long n = strtoull(value.c_str(), &endp, 10);
+                if (value.empty() || *endp != '\0') return PARSE_BAD;
+                if (n > MAX_BODY_BYTES) return PARSE_TOO_LARGE;
+                contentLength = (size_t)n;
+            } else if (iequals(name, "Transfer-Encoding")) {
+                return PARSE_UNSUPPORTED; // Chunked request bodies: our clients never send them
+            } else if (iequals(name, "Connection")) {
+                if (iequals(value, "close")) req.keepAlive = false;
+                else if (iequals(value, "keep-alive")) req.keepAlive = true;
+            } else if (iequals(name, "Expect")) {
+                expectContinue = iequals(value, "100-continue");
+            }
+        }
+
+        size_t bodyStart = headerEnd + 4;
+        if (buf.size() - bodyStart < contentLength) return PARSE_INCOMPLETE;
+        req.body = buf.substr(bodyStart, contentLength);
+        consumed = bodyStart + contentLength;
+        return PARSE_OK;
+    }
+
+    static const char* reason(int status) {
+        switch (status) {
+            case 200: return "OK";
+            case 400: return "Bad Request";
+            case 404: return "Not Found";
+            case 405: return "Method Not Allowed";
+            case 413: return "Payload Too Large";
+            case 501: return "Not Implemented";
+            default: return status < 500 ? "Error" : "Internal Server Error";
+        }
+    }
+
+    static string serialize(const HttpResponse& resp, bool keepAlive) {
+        string out = "HTTP/1.1 " + to_string(resp.status) + " " + reason(resp.status) + "\r\n";
+        out += "Content-Type: " + resp.contentType + "\r\n";
+        out += "Content-Length: " + to_string(resp.body.size()) + "\r\n";
+        out += keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+        out += resp.body;
+        return out;
+    }
+
+    // Bring the epoll registration in line with the connection's state
+    void watch(Connection& c) {
+        uint32_t events = (c.readPaused || c.peerClosed ? 0u : (uint32_t)(EPOLLIN | EPOLLRDHUP)) | (c.wantWrite ? (uint32_t)EPOLLOUT : 0u);
+        if (c.events == events) return;
+        epoll_event ev = {};
+        ev.events = events;
+        ev.data.fd = c.fd;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, c.fd, &ev);
+        c.events = events;
+    }
+
+    void closeConnection(int fd) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+        connections.erase(fd); // A response still with the workers is dropped by id
+    }
+
+    // Write as much pending output as the socket takes. Returns false if the
+    // connection was closed.
+    bool flush(Connection& c) {
+        while (c.outPos < c.out.size()) {
+            ssize_t n = ::send(c.fd, c.out.data() + c.outPos, c.out.size() - c.outPos, MSG_NOSIGNAL);
+            if (n > 0) {
+                c.outPos += (size_t)n;
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                c.wantWrite = true;
+                watch(c);
+                return true;
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else {
+                closeConnection(c.fd);
+                return false;
+            }
+        }
+        c.out.clear();
+        c.outPos = 0;
+        c.wantWrite = false;
+        watch(c);
+        if (c.closeAfterWrite && !c.busy) {
+            closeConnection(c.fd);
+            return false;
+        }
+        return true;
+    }
+
+    // Hand the next complete request to the workers, or answer a malformed one.
+    // Waits while a response is still being written, so a client that doesn't
+    // read can't pile up output. Returns false if the connection was closed.
+    bool dispatch(Connection& c) {
+        if (c.busy || c.closeAfterWrite || c.wantWrite) return true;
+        HttpRequest req;
+        size_t consumed = 0;
+        bool expectContinue = false;
+        ParseResult r = parseRequest(c.in, req, consumed, expectContinue);
+        if (r == PARSE_INCOMPLETE) {
+            if (c.peerClosed) {
+                // Nothing more is coming: close once the last response is out
+                c.closeAfterWrite = true;
+                return flush(c);
+            }
+            if (expectContinue && !c.sentContinue) {
+                c.out += "HTTP/1.1 100 Continue\r\n\r\n";
+                c.sentContinue = true;
+                return flush(c);
+            }
+            return true;
+        }
+        if (r != PARSE_OK) {
+            HttpResponse resp;
+            resp.status = r == PARSE_TOO_LARGE ? 413 : r == PARSE_UNSUPPORTED ? 501 : 400;
+            resp.body = "{\"status\":\"error\", \"msg\":\"" + string(reason(resp.status)) + "\"}";
+            c.out += serialize(resp, false);
+            c.closeAfterWrite = true;
+            c.in.clear();
+            return flush(c);
+        }
+
+        c.in.erase(0, consumed);
+        if (c.readPaused && c.in.size() < MAX_BUFFERED_INPUT) {
+            c.readPaused = false;
+            watch(c);
+        }
+        c.sentContinue = false;
+        c.busy = true;
+        {
+            lock_guard<mutex> lk(jobsLock);
+            jobs.push_back({c.fd, c.id, std::move(req)});
+        }
+        jobsReady.notify_one();
+        return true;
+    }
+
+    void onReadable(Connection& c) {
+        char chunk[READ_CHUNK];
+        while (true) {
+            ssize_t n = ::recv(c.fd, chunk, sizeof(chunk), 0);
+            if (n > 0) {
+                c.in.append(chunk, (size_t)n);
+                if (c.in.size() < MAX_BUFFERED_INPUT) continue;
+                // Full (a client pipelining faster than we answer): leave
+                // the rest in the socket until a request is handed off
+                c.readPaused = true;
+                watch(c);
+                break;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            if (n < 0) {
+                closeConnection(c.fd);
+                return;
+            }
+            // Half-close: the client may still be reading, so finish what's in
+            // flight and any complete requests already buffered
+            c.peerClosed = true;
+            watch(c);
+            break;
+        }
+        dispatch(c);
+    }
+
+    void acceptAll() {
+        while (true) {
+            int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) return; // EAGAIN, or a transient error: try again on the next event
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            epoll_event ev = {};
+            ev.events = EPOLLIN | EPOLLRDHUP;
+            ev.data.fd = fd;
+            if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+                ::close(fd);
+                continue;
+            }
+            Connection& c = connections[fd];
+            c = Connection();
+            c.fd = fd;
+            c.id = nextId++;
+        }
+    }
+
+    // Responses finished by the workers: queue them on their connections
+    void collectDone() {
+        uint64_t counter;
+        while (read(wakeFd, &counter, sizeof(counter)) > 0) {}
+
+        vector<Done> batch;
+        {
+            lock_guard<mutex> lk(doneLock);
+            batch.swap(done);
+        }
+        for (Done& d : batch) {
+            auto it = connections.find(d.fd);
+            if (it == connections.end() || it->second.id != d.id) continue; // Client went away
+            Connection& c = it->second;
+            c.busy = false;
+            c.out += d.bytes;
+            if (d.close) c.closeAfterWrite = true;
+            if (flush(c)) dispatch(c); // Next pipelined request, if any
+        }
+    }
+
+    void workerLoop() {
+        while (true) {
+            Job job;
+            {
+                unique_lock<mutex> lk(jobsLock);
+                jobsReady.wait(lk, [this] { return workersStopping || !jobs.empty(); });
+                if (jobs.empty()) return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+
+            HttpResponse resp;
+            try {
+                handler(job.request, resp);
+            } catch (const exception& e) {
+                resp.status = 500;
+                resp.body = "{\"status\":\"error\", \"msg\":\"Internal error\"}";
+            }
+            Done d = {job.fd, job.id, serialize(resp, job.request.keepAlive), !job.request.keepAlive};
+            {
+                lock_guard<mutex> lk(doneLock);
+                done.push_back(std::move(d));
+            }
+            uint64_t one = 1;
+            ssize_t ignored = write(wakeFd, &one, sizeof(one));
+            (void)ignored;
+        }
+    }
+
+public:
+    HttpServer(Handler h, size_t workerThreads) : handler(std::move(h)), workerCount(workerThreads > 0 ? workerThreads : 1) {}
+
+    HttpServer(const HttpServer&) = delete;
+    HttpServer& operator=(const HttpServer&) = delete;
+
+    ~HttpServer() {
+        for (auto& entry : connections) ::close(entry.first);
+        if (listenFd != -1) ::close(listenFd);
+        if (epollFd != -1) ::close(epollFd);
+        if (wakeFd != -1) ::close(wakeFd);
+    }
+
+    // Bind and listen on host:port (host "0.0.0.0" for all interfaces)
+    bool listen(const string& host, int port) {
+        listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd < 0) return false;
+        int one = 1;
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons((uint16_t)port);
+        if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) return false;
+        if (::bind(listenFd, (sockaddr*)&addr, sizeof(addr)) != 0 || ::listen(listenFd, SOMAXCONN) != 0) return false;
+
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epollFd < 0 || wakeFd < 0) return false;
+
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.fd = listenFd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+        ev.data.fd = wakeFd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+        return true;
+    }
+
+    // Serve until stop(). Requests still with the workers are finished before
+    // this returns; their responses are not sent.
+    void run() {
+        for (size_t i = 0; i < workerCount; ++i) workers.emplace_back(&HttpServer::workerLoop, this);
+
+        vector<epoll_event> events(256);
+        while (!stopRequested.load()) {
+            int n = epoll_wait(epollFd, events.data(), (int)events.size(), -1);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            for (int i = 0; i < n; ++i) {
+                int fd = events[i].data.fd;
+                if (fd == listenFd) {
+                    acceptAll();
+                } else if (fd == wakeFd) {
+                    collectDone();
+                } else {
+                    auto it = connections.find(fd);
+                    if (it == connections.end()) continue;
+                    uint32_t ev = events[i].events;
+                    if (ev & (EPOLLERR | EPOLLHUP)) {
+                        closeConnection(fd);
+                        continue;
+                    }
+                    if ((ev & EPOLLOUT) && !(flush(it->second) && dispatch(it->second))) continue;
+                    if (ev & (EPOLLIN | EPOLLRDHUP)) onReadable(it->second);
+                }
+            }
+        }
+
+        {
+            lock_guard<mutex> lk(jobsLock);
+            workersStopping = true;
+        }
+        jobsReady.notify_all();
+        for (thread& t : workers) t.join();
+        workers.clear();
+    }
+
+    // Safe from any thread and from a signal handler
+    void stop() {
+        stopRequested.store(true);
+        uint64_t one = 1;
+        ssize_t ignored = write(wakeFd, &one, sizeof(one));
+        (void)ignored;
+    }
+
+    size_t openConnections() const { return connections.size(); }
+};
+
+#endif // __linux__
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef INDEXEDORDERHEAP_H
+#define INDEXEDORDERHEAP_H
+
+#include <vector>
+#include <unordered_map>
+#include <utility>
+#include "Order.h"
+
+using namespace std;
+
+// Binary max-heap of orders that also tracks where each order ID sits.
+// Lookup is O(1); push, pop, remove and priority changes are O(log n).
+class IndexedOrderHeap {
+private:
+    vector<Order> heap;
+    unordered_map<int, size_t> position; // Order ID -> index in heap
+
+    void place(size_t i, const Order& o) {
+        heap[i] = o;
+        position[o.id] = i;
+    }
+
+    void siftUp(size_t i) {
+        Order moving = heap[i];
+        while (i > 0) {
+            size_t parent = (i - 1) / 2;
+            if (!(heap[parent] < moving)) break;
+            place(i, heap[parent]);
+            i = parent;
+        }
+        place(i, moving);
+    }
+
+    void siftDown(size_t i) {
+        Order moving = heap[i];
+        size_t n = heap.size();
+        while (true) {
+            size_t child = 2 * i + 1;
+            if (child >= n) break;
+            if (child + 1 < n && heap[child] < heap[child + 1]) ++child;
+            if (!(moving < heap[child])) break;
+            place(i, heap[child]);
+            i = child;
+        }
+        place(i, moving);
+    }
+
+    // Remove the element at index i, keeping the heap valid
+    Order removeAt(size_t i) {
+        Order removed = heap[i];
+        position.erase(removed.id);
+
+        Order last = heap.back();
+        heap.pop_back();
+        if (i < heap.size()) {
+            place(i, last);
+            siftUp(i);
+            siftDown(position[last.id]);
+        }
+        return removed;
+    }
+
+public:
+    bool empty() const { return heap.empty(); }
+    size_t size() const { return heap.size(); }
+
+    // Raw heap order (index 0 is the top); for read-only iteration
+    const vector<Order>& data() const { return heap; }
+
+    bool contains(int orderId) const { return position.count(orderId) > 0; }
+
+    const Order* find(int orderId) const {
+        auto it = position.find(orderId);
+        return it == position.end() ? nullptr : &heap[it->second];
+    }
+
+    void push(const Order& o) {
+        heap.push_back(o);
+        position[o.id] = heap.size() - 1;
+        siftUp(heap.size() - 1);
+    }
+
+    // Add many orders at once. A batch that is large next to the heap is
+    // appended and the whole heap rebuilt bottom-up in O(n); a small one into
+    // a big heap is cheaper sifted up one by one.
+    void pushAll(const vector<Order>& orders) {
+        size_t before = heap.size();
+        heap.reserve(before + orders.size());
+        for (const Order& o : orders) {
+            heap.push_back(o);
+            position[o.id] = heap.size() - 1;
+        }
+        if (orders.size() * 8 >= before) {
+            for (size_t i = heap.size() / 2; i-- > 0;) siftDown(i);
+        } else {
+            for (size_t i = before; i < heap.size(); ++i) siftUp(i);
+        }
+    }
+
+    const Order& top() const { return heap.front(); }
+
+    Order pop() { return removeAt(0); }
+
+    // Remove a specific order; returns false if it is not pending
+    bool remove(int orderId, Order* removed = nullptr) {
+        auto it = position.find(orderId);
+        if (it == position.end()) return false;
+        Order o = removeAt(it->second);
+        if (removed) *removed = o;
+        return true;
+    }
+
+    // Change an order's priority and restore heap order around it
+    bool updatePriority(int orderId, int priority) {
+        auto it = position.find(orderId);
+        if (it == position.end()) return false;
+        size_t i = it->second;
+        int old = heap[i].priority;
+        heap[i].priority = priority;
+        if (priority > old) siftUp(i);
+        else siftDown(i);
+        return true;
+    }
+
+    void clear() {
+        heap.clear();
+        position.clear();
+    }
+};
+
+#endif
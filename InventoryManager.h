@@ -1,74 +1,321 @@
 #ifndef INVENTORYMANAGER_H
 #define INVENTORYMANAGER_H
 
-#include <unordered_map>
 #include <string>
 #include <iostream>
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <algorithm>
+#include <unordered_map>
+#include <cassert>
+#include "Order.h"
+#include "FlatHashMap.h"
+#include "ChangeJournal.h"
 
 using namespace std;
 
+// 'quantity' is what can still be promised to new orders (placing an order
+// reserves from it). 'bins' is what is physically on the shelves, per bin; it
+// drops when an order is picked. locationNode is the item's primary bin.
 struct Item {
     int id;
     string name;
     int quantity;
     int locationNode;
+    vector<BinQuantity> bins;
 };
 
-// Manages warehouse inventory using a Hash Map for O(1) access
+// Manages warehouse inventory using a Hash Map for O(1) access.
+// The map is a flat open-addressing table: each call below does a single probe.
+//
+// Thread-safe mode (constructor flag) splits the items over lock-striped shards,
+// each with its own table and mutex, so threads placing orders against different
+// SKUs rarely contend. Every call then locks the one shard that owns the ID.
+// In that mode, use the copying accessors (getItemCopy, tryReserve with an out
+// parameter): raw Item pointers are only safe single-threaded. Stock only
+// leaves through tryReserve / tryReserveAll, which check and deduct under one
+// lock; a separate check followed by a deduction could oversell.
 class InventoryManager {
 private:
-    unordered_map<int, Item> inventory; // Key: ItemID, Value: Item object
+    struct Shard {
+        FlatHashMap<Item> items; // Key: ItemID, Value: Item object
+        mutex lock;
+    };
+
+    static const size_t CONCURRENT_SHARDS = 64;
+
+    bool threadSafe;
+    size_t shardCount;
+    unique_ptr<Shard[]> shards;
+    ChangeJournal* journal = nullptr; // Optional, for delta state queries
+
+    Shard& shardFor(int id) {
+        // Low bits of the ID are enough to spread sequential SKUs
+        return shards[(unsigned int)id % shardCount];
+    }
+
+    // Locks the shard only in thread-safe mode
+    unique_lock<mutex> guard(Shard& s) {
+        return threadSafe ? unique_lock<mutex>(s.lock) : unique_lock<mutex>();
+    }
+
+    void touch(int id) {
+        if (journal) journal->record(INVENTORY_ITEM, id);
+    }
+
+    // Items have a handful of bins; a linear scan beats any index
+    static BinQuantity* findBin(Item& item, int node) {
+        for (BinQuantity& b : item.bins) {
+            if (b.node == node) return &b;
+        }
+        return nullptr;
+    }
+
+    static void addToBin(Item& item, int node, int qty) {
+        BinQuantity* bin = findBin(item, node);
+        if (bin) bin->quantity += qty;
+        else item.bins.push_back({node, qty});
+    }
 
 public:
+    InventoryManager(bool concurrent = false)
+        : threadSafe(concurrent),
+          shardCount(concurrent ? CONCURRENT_SHARDS : 1),
+          shards(new Shard[concurrent ? CONCURRENT_SHARDS : 1]) {}
+
+    bool isThreadSafe() const { return threadSafe; }
+
+    void setJournal(ChangeJournal* j) { journal = j; }
+
+    // Pre-size the table(s) before a bulk load
+    void reserve(size_t capacity) {
+        for (size_t i = 0; i < shardCount; ++i) {
+            auto lk = guard(shards[i]);
+            shards[i].items.reserve(capacity / shardCount + 1);
+        }
+    }
+
     // Add new item to inventory
     void addItem(int id, string name, int qty, int loc) {
-        inventory[id] = {id, name, qty, loc};
+        Shard& s = shardFor(id);
+        {
+            auto lk = guard(s);
+            s.items.insert(id, {id, name, qty, loc, {{loc, qty}}});
+        }
+        touch(id);
+    }
+
+    // Bulk insert (inventory files): size every shard's table for its share up
+    // front so nothing rehashes mid-load. Rows for an ID that already exists add
+    // their stock to it (one row per bin for multi-bin SKUs).
+    void addItems(vector<Item>& items) {
+        vector<size_t> perShard(shardCount, 0);
+        for (const Item& item : items) ++perShard[(unsigned int)item.id % shardCount];
+        for (size_t i = 0; i < shardCount; ++i) {
+            auto lk = guard(shards[i]);
+            shards[i].items.reserve(shards[i].items.size() + perShard[i]);
+        }
+        for (Item& item : items) {
+            int id = item.id;
+            Shard& s = shardFor(id);
+            {
+                auto lk = guard(s);
+                Item* existing = s.items.find(id);
+                if (existing) {
+                    existing->quantity += item.quantity;
+                    for (const BinQuantity& b : item.bins) addToBin(*existing, b.node, b.quantity);
+                } else {
+                    s.items.insert(id, std::move(item));
+                }
+            }
+            touch(id);
+        }
+    }
+
+    // Restock: physical stock arrives at a bin and becomes available to orders
+    bool addStock(int id, int node, int qty) {
+        Shard& s = shardFor(id);
+        {
+            auto lk = guard(s);
+            Item* item = s.items.find(id);
+            if (!item) return false;
+            item->quantity += qty;
+            addToBin(*item, node, qty);
+        }
+        touch(id);
+        return true;
+    }
+
+    // Copy of an item's bins; false if the item is unknown
+    bool getBins(int id, vector<BinQuantity>& out) {
+        Shard& s = shardFor(id);
+        auto lk = guard(s);
+        Item* item = s.items.find(id);
+        if (!item) return false;
+        out = item->bins;
+        return true;
+    }
+
+    // Remove picked stock from the shelves. All or nothing: false, changing
+    // nothing, if any bin is missing or short.
+    bool takeFromBins(int id, const vector<BinQuantity>& picks) {
+        Shard& s = shardFor(id);
+        {
+            auto lk = guard(s);
+            Item* item = s.items.find(id);
+            if (!item) return false;
+            for (const BinQuantity& p : picks) {
+                BinQuantity* bin = findBin(*item, p.node);
+                if (!bin || bin->quantity < p.quantity) return false;
+            }
+            for (const BinQuantity& p : picks) findBin(*item, p.node)->quantity -= p.quantity;
+        }
+        touch(id);
+        return true;
+    }
+
+    // Undo of a pick: the stock goes back to the bins it came from
+    void returnToBins(int id, const vector<BinQuantity>& picks) {
+        Shard& s = shardFor(id);
+        {
+            auto lk = guard(s);
+            Item* item = s.items.find(id);
+            if (!item) return;
+            for (const BinQuantity& p : picks) addToBin(*item, p.node, p.quantity);
+        }
+        touch(id);
+    }
+
+    // Retrieve item details (nullptr if unknown).
+    // The pointer is invalidated by the next addItem; single-threaded use only.
+    Item* tryGet(int id) {
+        assert(!threadSafe && "raw Item pointers are unlocked; use getItemCopy");
+        return shardFor(id).items.find(id);
     }
 
-    // Retrieve item details
     Item* getItem(int id) {
-        if (inventory.find(id) != inventory.end()) {
-            return &inventory[id];
+        return tryGet(id);
+    }
+
+    // Copy of an item's current state; safe from any thread
+    bool getItemCopy(int id, Item& out) {
+        Shard& s = shardFor(id);
+        auto lk = guard(s);
+        const Item* item = s.items.find(id);
+        if (!item) return false;
+        out = *item;
+        return true;
+    }
+
+    // Check and deduct in one step, atomically in thread-safe mode (never
+    // oversells). On success the item after deduction is copied to 'reserved';
+    // returns false, deducting nothing, if it is unknown, short on stock, or
+    // qty <= 0 (a negative reservation would add stock).
+    bool tryReserve(int id, int qty, Item* reserved = nullptr) {
+        if (qty <= 0) return false;
+        Shard& s = shardFor(id);
+        {
+            auto lk = guard(s);
+            Item* item = s.items.find(id);
+            if (!item || item->quantity < qty) return false;
+            item->quantity -= qty;
+            if (reserved) *reserved = *item;
         }
-        return nullptr;
+        touch(id);
+        return true;
     }
 
-    // Check availability
-    bool hasStock(int id, int qty) {
-        if (inventory.find(id) != inventory.end()) {
-            return inventory[id].quantity >= qty;
+    // All-or-nothing tryReserve for a batch of (itemId, qty) lines; lines for
+    // the same item add up. On success 'reserved' holds each line's item after
+    // every deduction. On failure nothing changes and 'failedLine' is the first
+    // line that can't be met (unknown item, qty <= 0, or not enough stock left).
+    bool tryReserveAll(const vector<pair<int, int>>& lines, vector<Item>& reserved, size_t& failedLine) {
+        // Every shard involved stays locked for check + deduct, taken in index order
+        vector<size_t> shardIds;
+        for (const auto& line : lines) shardIds.push_back((unsigned int)line.first % shardCount);
+        sort(shardIds.begin(), shardIds.end());
+        shardIds.erase(unique(shardIds.begin(), shardIds.end()), shardIds.end());
+        vector<unique_lock<mutex>> locks;
+        locks.reserve(shardIds.size());
+        for (size_t i : shardIds) locks.push_back(guard(shards[i]));
+
+        unordered_map<int, int> totals; // Item ID -> quantity asked for so far
+        vector<Item*> items(lines.size());
+        for (size_t i = 0; i < lines.size(); ++i) {
+            Item* item = shardFor(lines[i].first).items.find(lines[i].first);
+            int& total = totals[lines[i].first];
+            total += lines[i].second;
+            if (!item || lines[i].second <= 0 || item->quantity < total) {
+                failedLine = i;
+                return false;
+            }
+            items[i] = item;
         }
-        return false;
+        for (size_t i = 0; i < lines.size(); ++i) items[i]->quantity -= lines[i].second;
+
+        reserved.clear();
+        reserved.reserve(lines.size());
+        for (Item* item : items) reserved.push_back(*item);
+        locks.clear();
+        for (const auto& entry : totals) touch(entry.first);
+        return true;
     }
 
-    // Update stock level (can be negative for deduction)
+    // Update stock level. Negative changes are refused in thread-safe mode:
+    // deductions go through tryReserve, which checks under the same lock.
     bool updateStock(int id, int change) {
-        if (inventory.find(id) != inventory.end()) {
-            inventory[id].quantity += change;
-            return true;
+        if (threadSafe && change < 0) return false;
+        Shard& s = shardFor(id);
+        {
+            auto lk = guard(s);
+            Item* item = s.items.find(id);
+            if (!item) return false;
+            item->quantity += change;
         }
-        return false;
+        touch(id);
+        return true;
+    }
+
+    size_t size() {
+        size_t total = 0;
+        for (size_t i = 0; i < shardCount; ++i) {
+            auto lk = guard(shards[i]);
+            total += shards[i].items.size();
+        }
+        return total;
     }
     
     void displayInventory() {
         cout << "\n--- Current Inventory (Hash Map) ---\n";
         cout << "ID\tName\t\tQty\tLocation\n";
         cout << "------------------------------------\n";
-        for (auto& pair : inventory) {
-             cout << pair.first << "\t" << pair.second.name 
-                  << "\t\t" << pair.second.quantity << "\tNode " << pair.second.locationNode << "\n";
+        for (const Item& item : getInventory()) {
+             cout << item.id << "\t" << item.name 
+                  << "\t\t" << item.quantity << "\tNode " << item.locationNode;
+             if (item.bins.size() > 1) cout << " (+" << item.bins.size() - 1 << " more bins)";
+             cout << "\n";
         }
         cout << "------------------------------------\n";
     }
 
     // --- Accessor for GUI ---
+    // Shards are copied one at a time (each one is consistent on its own)
     vector<Item> getInventory() {
         vector<Item> items;
-        for (auto& pair : inventory) {
-            items.push_back(pair.second);
-        }
+        items.reserve(size());
+        forEachItem([&items](const Item& item) { items.push_back(item); });
         return items;
     }
+
+    // Visit every item in place, in table order (the order getInventory uses)
+    template <typename F>
+    void forEachItem(F visit) {
+        for (size_t i = 0; i < shardCount; ++i) {
+            auto lk = guard(shards[i]);
+            shards[i].items.forEach([&visit](int, const Item& item) { visit(item); });
+        }
+    }
 };
 
 #endif
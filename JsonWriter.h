@@ -0,0 +1,108 @@
+#ifndef JSONWRITER_H
+#define JSONWRITER_H
+
+#include <string>
+#include <cstdio>
+#include <charconv>
+#include <cmath>
+#include <ostream>
+
+using namespace std;
+
+// Appends JSON text to one growable buffer. Strings are escaped; numbers are
+// formatted without going through iostreams. clear() keeps the capacity, so a
+// writer reused across requests stops allocating once it has grown.
+class JsonWriter {
+private:
+    string buf;
+
+public:
+    JsonWriter& raw(const char* s) {
+        buf += s;
+        return *this;
+    }
+
+    JsonWriter& raw(const string& s) {
+        buf += s;
+        return *this;
+    }
+
+    JsonWriter& raw(const char* s, size_t n) {
+        buf.append(s, n);
+        return *this;
+    }
+
+    JsonWriter& raw(char c) {
+        buf += c;
+        return *this;
+    }
+
+    JsonWriter& integer(long long v) {
+        char tmp[24];
+        auto res = to_chars(tmp, tmp + sizeof(tmp), v);
+        buf.append(tmp, res.ptr);
+        return *this;
+    }
+
+    // Same text as ostream's default formatting (%g, 6 significant digits).
+    // NaN and infinities have no JSON spelling: they become null.
+    JsonWriter& number(double v) {
+        if (!isfinite(v)) {
+            buf += "null";
+            return *this;
+        }
+        char tmp[32];
+        int n = snprintf(tmp, sizeof(tmp), "%g", v);
+        buf.append(tmp, n > 0 ? (size_t)n : 0);
+        return *this;
+    }
+
+    // String contents without the surrounding quotes
+    JsonWriter& escaped(const string& s) {
+        static const char* hex = "0123456789abcdef";
+        size_t plain = 0; // Start of the run not yet copied
+        for (size_t i = 0; i < s.size(); ++i) {
+            unsigned char c = (unsigned char)s[i];
+            if (c >= 0x20 && c != '"' && c != '\\') continue;
+            buf.append(s, plain, i - plain);
+            plain = i + 1;
+            switch (c) {
+                case '"': buf += "\\\""; break;
+                case '\\': buf += "\\\\"; break;
+                case '\n': buf += "\\n"; break;
+                case '\r': buf += "\\r"; break;
+                case '\t': buf += "\\t"; break;
+                default:
+                    buf += "\\u00";
+                    buf += hex[c >> 4];
+                    buf += hex[c & 0xf];
+            }
+        }
+        buf.append(s, plain, s.size() - plain);
+        return *this;
+    }
+
+    JsonWriter& quoted(const string& s) {
+        buf += '"';
+        escaped(s);
+        buf += '"';
+        return *this;
+    }
+
+    const string& str() const { return buf; }
+    size_t size() const { return buf.size(); }
+    void clear() { buf.clear(); }
+
+    // Drop everything written after size() was 'mark'
+    void truncate(size_t mark) {
+        if (mark < buf.size()) buf.resize(mark);
+    }
+
+    // Hand the text to a stream in one write and start over
+    void flushTo(ostream& out) {
+        out.write(buf.data(), (streamsize)buf.size());
+        buf.clear();
+    }
+};
+
+#endif
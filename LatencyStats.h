@@ -0,0 +1,208 @@
+#ifndef LATENCYSTATS_H
+#define LATENCYSTATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <iostream>
+
+using namespace std;
+
+// Log-linear (HDR-style) latency histogram in nanoseconds. Values below 64 get
+// exact buckets; above that each power of two is split into 32 buckets, so any
+// reported percentile is within ~3% of the true value. Fixed size (~10 KB),
+// no allocation on record. Counters are relaxed atomics: routing workers
+// record Dijkstra spans concurrently with the API thread.
+class LatencyHistogram {
+private:
+    static const int SUB_BITS = 6;                          // 64 linear buckets
+    static const uint64_t SUB_COUNT = 1ull << SUB_BITS;
+    static const uint64_t HALF_COUNT = SUB_COUNT / 2;
+    static const int MAX_BITS = 42;                         // ~73 minutes
+    static const size_t BUCKETS = SUB_COUNT + (MAX_BITS - SUB_BITS) * HALF_COUNT;
+
+    atomic<uint64_t> buckets[BUCKETS];
+    atomic<uint64_t> total;
+    atomic<uint64_t> sumNs;
+    atomic<uint64_t> maxNs;
+
+    static int highestBit(uint64_t v) {
+#if defined(__GNUC__)
+        return 63 - __builtin_clzll(v);
+#else
+        int bit = 0;
+        while (v >>= 1) ++bit;
+        return bit;
+#endif
+    }
+
+    static size_t bucketOf(uint64_t v) {
+        if (v < SUB_COUNT) return (size_t)v;
+        if (v >= (1ull << MAX_BITS)) v = (1ull << MAX_BITS) - 1;
+        int shift = highestBit(v) - (SUB_BITS - 1);  // >= 1
+        uint64_t sub = v >> shift;                   // In [HALF_COUNT, SUB_COUNT)
+        return (size_t)(SUB_COUNT + (shift - 1) * HALF_COUNT + (sub - HALF_COUNT));
+    }
+
+    // Largest value that lands in bucket i
+    static uint64_t bucketUpper(size_t i) {
+        if (i < SUB_COUNT) return i;
+        size_t shift = (i - SUB_COUNT) / HALF_COUNT + 1;
+        uint64_t sub = (i - SUB_COUNT) % HALF_COUNT + HALF_COUNT;
+        return ((sub + 1) << shift) - 1;
+    }
+
+public:
+    LatencyHistogram() {
+        reset();
+    }
+
+    void record(uint64_t ns) {
+        buckets[bucketOf(ns)].fetch_add(1, memory_order_relaxed);
+        total.fetch_add(1, memory_order_relaxed);
+        sumNs.fetch_add(ns, memory_order_relaxed);
+        uint64_t seen = maxNs.load(memory_order_relaxed);
+        while (ns > seen && !maxNs.compare_exchange_weak(seen, ns, memory_order_relaxed)) {}
+    }
+
+    uint64_t count() const { return total.load(memory_order_relaxed); }
+    uint64_t maxValue() const { return maxNs.load(memory_order_relaxed); }
+
+    double meanNs() const {
+        uint64_t n = count();
+        return n ? (double)sumNs.load(memory_order_relaxed) / n : 0;
+    }
+
+    // Upper edge of the bucket holding the p-quantile (capped at the max seen)
+    uint64_t percentile(double p) const {
+        uint64_t n = count();
+        if (n == 0) return 0;
+        uint64_t rank = (uint64_t)(p * n);
+        if (rank >= n) rank = n - 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            seen += buckets[i].load(memory_order_relaxed);
+            if (seen > rank) {
+                uint64_t upper = bucketUpper(i);
+                return upper < maxValue() ? upper : maxValue();
+            }
+        }
+        return maxValue();
+    }
+
+    void reset() {
+        for (size_t i = 0; i < BUCKETS; ++i) buckets[i].store(0, memory_order_relaxed);
+        total.store(0, memory_order_relaxed);
+        sumNs.store(0, memory_order_relaxed);
+        maxNs.store(0, memory_order_relaxed);
+    }
+
+    // {"count": .., "meanUs": .., "p50Us": .., "p90Us": .., "p99Us": .., "p999Us": .., "maxUs": ..}
+    void printJSON(ostream& out) const {
+        out << "{\"count\": " << count()
+            << ", \"meanUs\": " << meanNs() / 1000.0
+            << ", \"p50Us\": " << percentile(0.50) / 1000.0
+            << ", \"p90Us\": " << percentile(0.90) / 1000.0
+            << ", \"p99Us\": " << percentile(0.99) / 1000.0
+            << ", \"p999Us\": " << percentile(0.999) / 1000.0
+            << ", \"maxUs\": " << maxValue() / 1000.0 << "}";
+    }
+};
+
+// Inner spans timed inside the engine
+enum SpanKind {
+    SPAN_DIJKSTRA,   // Shortest-path tree builds/repairs and single-pair searches
+    SPAN_HEAP,       // Pending-order heap push/pop/remove/reprioritize
+    SPAN_JSON,       // State serialization
+    SPAN_KINDS
+};
+
+// Per-command and per-span histograms for API mode (STATS / STATS_RESET).
+// Safe to record from any thread: the command map is guarded (HTTP mode
+// serves reads concurrently), the histograms themselves are atomic.
+class LatencyStats {
+private:
+    static const size_t MAX_COMMANDS = 64; // Junk input can't grow the map (or break the JSON)
+
+    map<string, unique_ptr<LatencyHistogram>> commands;
+    mutable mutex commandsLock; // Guards the map, not the histograms
+    LatencyHistogram spans[SPAN_KINDS];
+
+    static const char* spanName(int kind) {
+        static const char* names[SPAN_KINDS] = {"dijkstra", "heap", "json"};
+        return names[kind];
+    }
+
+public:
+    void recordCommand(const string& name, uint64_t ns) {
+        lock_guard<mutex> lk(commandsLock);
+        auto it = commands.find(name);
+        if (it == commands.end()) {
+            bool plain = !name.empty() && commands.size() < MAX_COMMANDS;
+            for (char c : name) plain = plain && ((c >= 'A' && c <= 'Z') || c == '_');
+            string key = plain ? name : "OTHER";
+            it = commands.find(key);
+            if (it == commands.end()) it = commands.emplace(key, unique_ptr<LatencyHistogram>(new LatencyHistogram())).first;
+        }
+        it->second->record(ns);
+    }
+
+    void recordSpan(SpanKind kind, uint64_t ns) {
+        spans[kind].record(ns);
+    }
+
+    LatencyHistogram& span(SpanKind kind) { return spans[kind]; }
+
+    void reset() {
+        lock_guard<mutex> lk(commandsLock);
+        for (auto& entry : commands) entry.second->reset();
+        for (auto& h : spans) h.reset();
+    }
+
+    void printJSON(ostream& out) const {
+        out << "{\"status\": \"success\", \"commands\": {";
+        const char* sep = "";
+        lock_guard<mutex> lk(commandsLock);
+        for (const auto& entry : commands) {
+            if (entry.second->count() == 0) continue;
+            out << sep << "\"" << entry.first << "\": ";
+            entry.second->printJSON(out);
+            sep = ", ";
+        }
+        out << "}, \"spans\": {";
+        for (int i = 0; i < SPAN_KINDS; ++i) {
+            out << (i ? ", " : "") << "\"" << spanName(i) << "\": ";
+            spans[i].printJSON(out);
+        }
+        out << "}}" << endl;
+    }
+};
+
+// Times its scope into one span; a null stats pointer costs nothing
+class SpanTimer {
+private:
+    LatencyStats* stats;
+    SpanKind kind;
+    chrono::steady_clock::time_point start;
+
+public:
+    SpanTimer(LatencyStats* s, SpanKind k) : stats(s), kind(k) {
+        if (stats) start = chrono::steady_clock::now();
+    }
+
+    ~SpanTimer() {
+        if (stats) {
+            auto ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+            stats->recordSpan(kind, (uint64_t)ns);
+        }
+    }
+
+    SpanTimer(const SpanTimer&) = delete;
+    SpanTimer& operator=(const SpanTimer&) = delete;
+};
+
+#endif
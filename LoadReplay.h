@@ -0,0 +1,231 @@
+#ifndef LOADREPLAY_H
+#define LOADREPLAY_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <random>
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+// Command streams for load testing: record what the API loop receives, then
+// play it (or a synthetic mix) back into the engine in-process.
+//
+// Stream file format, one command per line:
+//   <microseconds since recording started> <command line>
+// Lines starting with '#' are comments.
+
+struct RecordedCommand {
+    long long offsetUs;
+    string line;
+};
+
+// Appends incoming API command lines with their arrival time
+class CommandRecorder {
+private:
+    FILE* file = nullptr;
+    chrono::steady_clock::time_point start;
+    size_t recorded = 0;
+    mutex lock; // HTTP workers record concurrently
+
+public:
+    CommandRecorder() {}
+    CommandRecorder(const CommandRecorder&) = delete;
+    CommandRecorder& operator=(const CommandRecorder&) = delete;
+
+    ~CommandRecorder() {
+        close();
+    }
+
+    bool open(const string& path) {
+        close();
+        file = fopen(path.c_str(), "w");
+        if (!file) return false;
+        fputs("# warehouse command stream v1\n", file);
+        start = chrono::steady_clock::now();
+        recorded = 0;
+        return true;
+    }
+
+    // Buffered by stdio; flushed on close
+    void record(const string& line) {
+        lock_guard<mutex> lk(lock);
+        if (!file) return;
+        long long us = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+        fprintf(file, "%lld %s\n", us, line.c_str());
+        ++recorded;
+    }
+
+    size_t count() const { return recorded; }
+
+    void close() {
+        if (file) fclose(file);
+        file = nullptr;
+    }
+};
+
+inline bool loadCommandStream(const string& path, vector<RecordedCommand>& out) {
+    ifstream in(path);
+    if (!in) return false;
+    string line;
+    while (getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        size_t space = line.find(' ');
+        if (space == string::npos) continue;
+        out.push_back({atoll(line.c_str()), line.substr(space + 1)});
+    }
+    return true;
+}
+
+// Relative weights of each command in a synthetic stream
+struct CommandMix {
+    int addOrder = 50;
+    int process = 20;
+    int dispatch = 15;
+    int undo = 5;
+    int getState = 10;
+};
+
+// "add=60,process=20,dispatch=10,undo=5,state=5"; unknown keys are ignored
+inline CommandMix parseCommandMix(const string& spec) {
+    CommandMix mix;
+    stringstream ss(spec);
+    string part;
+    while (getline(ss, part, ',')) {
+        size_t eq = part.find('=');
+        if (eq == string::npos) continue;
+        string key = part.substr(0, eq);
+        int weight = max(0, atoi(part.c_str() + eq + 1));
+        if (key == "add") mix.addOrder = weight;
+        else if (key == "process") mix.process = weight;
+        else if (key == "dispatch") mix.dispatch = weight;
+        else if (key == "undo") mix.undo = weight;
+        else if (key == "state") mix.getState = weight;
+    }
+    return mix;
+}
+
+// 'count' commands drawn from 'mix', spaced evenly at 'ratePerSec' for paced
+// playback. ADD_ORDER picks a random item from 'itemIds', qty 1, priority 1-10.
+inline vector<RecordedCommand> generateCommandStream(size_t count, const CommandMix& mix, const vector<int>& itemIds,
+                                                     double ratePerSec, unsigned seed) {
+    vector<RecordedCommand> stream;
+    stream.reserve(count);
+    mt19937 rng(seed);
+    discrete_distribution<int> pick({(double)mix.addOrder, (double)mix.process, (double)mix.dispatch,
+                                     (double)mix.undo, (double)mix.getState});
+    double gapUs = ratePerSec > 0 ? 1e6 / ratePerSec : 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        string line;
+        switch (pick(rng)) {
+            case 0:
+                if (itemIds.empty()) continue;
+                line = "ADD_ORDER " + to_string(itemIds[rng() % itemIds.size()]) + " 1 " + to_string(1 + rng() % 10);
+                break;
+            case 1: line = "PROCESS"; break;
+            case 2: line = "DISPATCH"; break;
+            case 3: line = "UNDO"; break;
+            default: line = "GET_STATE 50"; break;
+        }
+        stream.push_back({(long long)(i * gapUs), line});
+    }
+    return stream;
+}
+
+struct CommandLatency {
+    string command;
+    size_t count;
+    double totalMs;
+    double p50Us, p99Us, p999Us, maxUs;
+};
+
+struct ReplayReport {
+    size_t commands = 0;
+    double wallMs = 0;
+    double behindMs = 0; // Paced playback: worst lag behind the recorded schedule
+    vector<CommandLatency> perCommand;
+
+    double throughput() const { return wallMs > 0 ? commands / (wallMs / 1000.0) : 0; }
+};
+
+// Nearest-rank percentile of sorted samples
+inline double percentile(const vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t rank = (size_t)(p * sorted.size());
+    return sorted[min(rank, sorted.size() - 1)];
+}
+
+// Feed 'stream' to 'execute' one line at a time. speed 0 runs flat out;
+// otherwise each command waits for its recorded offset divided by speed
+// (1 = recorded pace, 2 = twice as fast). Latency is per execute() call.
+inline ReplayReport replayCommands(const vector<RecordedCommand>& stream, double speed,
+                                   const function<void(const string&)>& execute) {
+    map<string, vector<double>> samples; // Command name -> latencies in microseconds
+    ReplayReport report;
+
+    auto start = chrono::steady_clock::now();
+    long long firstOffset = stream.empty() ? 0 : stream.front().offsetUs;
+    for (const RecordedCommand& cmd : stream) {
+        if (speed > 0) {
+            auto due = start + chrono::microseconds((long long)((cmd.offsetUs - firstOffset) / speed));
+            auto now = chrono::steady_clock::now();
+            if (now < due) {
+                this_thread::sleep_until(due);
+            } else {
+                report.behindMs = max(report.behindMs, chrono::duration<double, milli>(now - due).count());
+            }
+        }
+
+        auto t0 = chrono::steady_clock::now();
+        execute(cmd.line);
+        double us = chrono::duration<double, micro>(chrono::steady_clock::now() - t0).count();
+
+        string name = cmd.line.substr(0, cmd.line.find(' '));
+        samples[name].push_back(us);
+        ++report.commands;
+    }
+    report.wallMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    for (auto& entry : samples) {
+        vector<double>& s = entry.second;
+        sort(s.begin(), s.end());
+        double total = 0;
+        for (double us : s) total += us;
+        report.perCommand.push_back({entry.first, s.size(), total / 1000.0,
+                                     percentile(s, 0.50), percentile(s, 0.99), percentile(s, 0.999), s.back()});
+    }
+    return report;
+}
+
+inline void printReplayReportJSON(const ReplayReport& r, ostream& out) {
+    out << "{\"status\": \"success\", \"commands\": " << r.commands
+        << ", \"wallMs\": " << r.wallMs
+        << ", \"throughput\": " << r.throughput()
+        << ", \"behindMs\": " << r.behindMs
+        << ", \"perCommand\": [";
+    for (size_t i = 0; i < r.perCommand.size(); ++i) {
+        const CommandLatency& c = r.perCommand[i];
+        out << "{\"command\": \"" << c.command << "\", \"count\": " << c.count
+            << ", \"totalMs\": " << c.totalMs
+            << ", \"p50Us\": " << c.p50Us
+            << ", \"p99Us\": " << c.p99Us
+            << ", \"p999Us\": " << c.p999Us
+            << ", \"maxUs\": " << c.maxUs << "}";
+        if (i < r.perCommand.size() - 1) out << ",";
+    }
+    out << "]}" << endl;
+}
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef LOCKFREEQUEUE_H
+#define LOCKFREEQUEUE_H
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+using namespace std;
+
+// Round up to a power of two so ring positions can be masked
+inline size_t roundUpPow2(size_t n) {
+    size_t cap = 2;
+    while (cap < n) cap *= 2;
+    return cap;
+}
+
+// Bounded multi-producer / multi-consumer ring (Vyukov's design).
+// Each cell carries a sequence number that tells producers and consumers
+// whether it is free for the current lap, so no locks are needed.
+template <typename T>
+class MpmcQueue {
+private:
+    struct Cell {
+        atomic<size_t> seq;
+        T data;
+    };
+
+    unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) atomic<size_t> enqueuePos;
+    alignas(64) atomic<size_t> dequeuePos;
+
+public:
+    MpmcQueue(size_t capacity)
+        : cells(new Cell[roundUpPow2(capacity)]), mask(roundUpPow2(capacity) - 1), enqueuePos(0), dequeuePos(0) {
+        for (size_t i = 0; i <= mask; ++i) cells[i].seq.store(i, memory_order_relaxed);
+    }
+
+    // Returns false when full (caller applies backpressure)
+    bool tryPush(T&& value) {
+        size_t pos = enqueuePos.load(memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &cells[pos & mask];
+            size_t seq = cell->seq.load(memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueuePos.load(memory_order_relaxed);
+            }
+        }
+        cell->data = std::move(value);
+        cell->seq.store(pos + 1, memory_order_release);
+        return true;
+    }
+
+    // Returns false when empty
+    bool tryPop(T& out) {
+        size_t pos = dequeuePos.load(memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &cells[pos & mask];
+            size_t seq = cell->seq.load(memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeuePos.load(memory_order_relaxed);
+            }
+        }
+        out = std::move(cell->data);
+        cell->seq.store(pos + mask + 1, memory_order_release);
+        return true;
+    }
+
+    // Approximate number of queued items (exact when quiescent)
+    size_t sizeApprox() const {
+        size_t head = dequeuePos.load(memory_order_relaxed);
+        size_t tail = enqueuePos.load(memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    size_t capacity() const { return mask + 1; }
+};
+
+// Bounded single-producer / single-consumer ring.
+// Only the producer writes 'tail' and only the consumer writes 'head'.
+template <typename T>
+class SpscQueue {
+private:
+    unique_ptr<T[]> buffer;
+    size_t mask;
+    alignas(64) atomic<size_t> head; // Next slot to read
+    alignas(64) atomic<size_t> tail; // Next slot to write
+
+public:
+    SpscQueue(size_t capacity)
+        : buffer(new T[roundUpPow2(capacity)]), mask(roundUpPow2(capacity) - 1), head(0), tail(0) {}
+
+    bool tryPush(T&& value) {
+        size_t t = tail.load(memory_order_relaxed);
+        if (t - head.load(memory_order_acquire) > mask) return false; // Full
+        buffer[t & mask] = std::move(value);
+        tail.store(t + 1, memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& out) {
+        size_t h = head.load(memory_order_relaxed);
+        if (h == tail.load(memory_order_acquire)) return false; // Empty
+        out = std::move(buffer[h & mask]);
+        head.store(h + 1, memory_order_release);
+        return true;
+    }
+
+    size_t sizeApprox() const {
+        size_t h = head.load(memory_order_relaxed);
+        size_t t = tail.load(memory_order_relaxed);
+        return t > h ? t - h : 0;
+    }
+
+    size_t capacity() const { return mask + 1; }
+};
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstddef>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// Read-only view of a whole file. Memory-mapped where the platform allows
+// (no copy, pages fault in on demand); otherwise read into a buffer.
+class MappedFile {
+private:
+    const char* bytes = nullptr;
+    size_t length = 0;
+    bool mapped = false;
+    vector<char> fallback;
+
+public:
+    MappedFile() {}
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        close();
+    }
+
+    bool open(const string& path) {
+        close();
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                bytes = (const char*)p;
+                length = (size_t)st.st_size;
+                mapped = true;
+                ::close(fd);
+                return true;
+            }
+        } else if (fstat(fd, &st) == 0) {
+            ::close(fd); // Empty file: nothing to map
+            return true;
+        }
+        ::close(fd);
+#endif
+        FILE* f = fopen(path.c_str(), "rb");
+        if (!f) return false;
+        fseek(f, 0, SEEK_END);
+        long size = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        fallback.resize(size > 0 ? (size_t)size : 0);
+        size_t got = fallback.empty() ? 0 : fread(fallback.data(), 1, fallback.size(), f);
+        fclose(f);
+        fallback.resize(got);
+        bytes = fallback.data();
+        length = got;
+        return true;
+    }
+
+    void close() {
+#ifndef _WIN32
+        if (mapped) munmap((void*)bytes, length);
+#endif
+        mapped = false;
+        bytes = nullptr;
+        length = 0;
+        fallback.clear();
+    }
+
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+    bool isMapped() const { return mapped; }
+};
+
+#endif
@@ -2,20 +2,32 @@
 #define ORDER_H
 
 #include <string>
+#include <vector>
+
+// Stock of one item at one storage bin (graph node)
+struct BinQuantity {
+    int node;
+    int quantity;
+};
 
 // Represents a customer order in the warehouse
 struct Order {
     int id;
     int priority;           // Higher value = higher priority
+    int itemId;             // Inventory item the order draws stock from
     std::string itemName;
     int quantity;
-    int itemLocationNode;   // Node ID in the graph where item is located
+    int itemLocationNode;   // Node ID in the graph where item is located (nearest picked bin once processed)
+    std::vector<BinQuantity> picks; // Bins the order was picked from (empty while pending)
 
     // Overloading < operator for priority_queue
     // The priority_queue is a max-heap, so the largest element is at the top.
     // By returning true if this.priority < other.priority, we ensure higher priority values come first.
+    // Equal priorities go oldest (lowest ID) first. The order is then total, so which
+    // order is "next" never depends on the heap's internal layout (WAL replay relies on it).
     bool operator<(const Order& other) const {
-        return priority < other.priority; 
+        if (priority != other.priority) return priority < other.priority;
+        return id > other.id;
     }
 };
 
@@ -8,17 +8,30 @@
 #include <iostream>
 #include <string>
 #include "Order.h"
+#include "IndexedOrderHeap.h"
 #include "WarehouseGraph.h"
+#include "InventoryManager.h"
 #include "ActionHistory.h"
+#include "ChangeJournal.h"
+#include "WavePlanner.h"
+#include "LatencyStats.h"
 
 using namespace std;
 
+// Outcome of routing a pick wave
+struct WaveResult {
+    vector<Order> orders;   // Orders picked, in tour order
+    vector<int> tour;       // Node sequence visited, starting and ending at the depot
+    int tourDistance;       // Length of the optimized tour
+    int individualDistance; // Same orders as separate depot round trips
+};
+
 // Manages order processing using Heap (Priority Queue) and Dispatch Queue (FIFO)
 class OrderManager {
 private:
-    // We use a vector with heap algorithms instead of priority_queue
-    // to allow random access removal for UNDO functionality.
-    vector<Order> orderHeap;
+    // Indexed heap instead of priority_queue: it tracks each order's slot,
+    // so UNDO, cancel and reprioritize can reach any pending order in O(log n).
+    IndexedOrderHeap orderHeap;
     
     // FIFO Queue for dispatched orders.
     // std::deque allows removal from back if we want to undo dispatch easily?
@@ -28,65 +41,304 @@ private:
     deque<Order> dispatchQueue;
 
     ActionHistory* historyLogger;
+    ChangeJournal* journal = nullptr; // Optional, for delta state queries
+    LatencyStats* stats = nullptr;    // Optional, times heap maintenance
+
+    // All heap / dispatch queue mutations go through these so the journal sees them
+    void touch(EntityKind kind, int orderId) {
+        if (journal) journal->record(kind, orderId);
+    }
+
+    void pushPending(const Order& order) {
+        {
+            SpanTimer timer(stats, SPAN_HEAP);
+            orderHeap.push(order);
+        }
+        touch(PENDING_ORDER, order.id);
+    }
+
+    Order popPending() {
+        Order order;
+        {
+            SpanTimer timer(stats, SPAN_HEAP);
+            order = orderHeap.pop();
+        }
+        touch(PENDING_ORDER, order.id);
+        return order;
+    }
+
+    bool removePending(int orderId, Order* removed = nullptr) {
+        bool found;
+        {
+            SpanTimer timer(stats, SPAN_HEAP);
+            found = orderHeap.remove(orderId, removed);
+        }
+        if (!found) return false;
+        touch(PENDING_ORDER, orderId);
+        return true;
+    }
+
+    void pushDispatch(const Order& order) {
+        dispatchQueue.push_back(order);
+        touch(DISPATCHED_ORDER, order.id);
+    }
 
 public:
     OrderManager(ActionHistory* history) : historyLogger(history) {}
 
+    void setJournal(ChangeJournal* j) { journal = j; }
+    void setStats(LatencyStats* s) { stats = s; }
+
+    // Not logged here; the caller records the ADD_ORDER with its stock change
     void addOrder(const Order& order) {
-        orderHeap.push_back(order);
-        push_heap(orderHeap.begin(), orderHeap.end());
-        
-        // Log for Undo
-        historyLogger->logAction({ADD_ORDER, order.id, 0, order.quantity, order.priority}); 
-        // Note: itemId is not strictly in Order struct, simplistic mapping would need improvement 
-        // but main.cpp passes itemId to history ideally. Order struct has itemName only.
-        // We will fix main.cpp to log the ID. The OrderManager logAction might be redundant if main handles it.
-        // Let's ONLY use OrderManager helper methods and let MAIN log the high level transaction to ensure 
-        // Inventory + Order undo are coupled.
+        pushPending(order);
     }
     
+    // Bulk insert for ADD_ORDERS: one heap rebuild instead of a push per order.
+    // Not logged here; the caller records one compound undo entry.
+    void addOrders(const vector<Order>& orders) {
+        if (orders.empty()) return;
+        {
+            SpanTimer timer(stats, SPAN_HEAP);
+            orderHeap.pushAll(orders);
+        }
+        for (const Order& o : orders) touch(PENDING_ORDER, o.id);
+    }
+
     // Helper to remove a specific order by ID (needed for Undo Add)
     bool removeOrder(int orderId) {
-        auto it = find_if(orderHeap.begin(), orderHeap.end(), [orderId](const Order& o) {
-            return o.id == orderId;
+        return removePending(orderId);
+    }
+
+    // Put an order back into the pending heap without logging (used by UNDO)
+    void restoreOrder(const Order& order) {
+        pushPending(order);
+    }
+
+    // Cancel a pending order; the removed order is copied to 'cancelled'
+    bool cancelOrder(int orderId, Order* cancelled = nullptr) {
+        return removePending(orderId, cancelled);
+    }
+
+    // Change the priority of a pending order
+    bool updatePriority(int orderId, int priority) {
+        bool found;
+        {
+            SpanTimer timer(stats, SPAN_HEAP);
+            found = orderHeap.updatePriority(orderId, priority);
+        }
+        if (!found) return false;
+        touch(PENDING_ORDER, orderId);
+        return true;
+    }
+
+    // Lookup of a pending order (nullptr if not pending)
+    const Order* findPendingOrder(int orderId) const {
+        return orderHeap.find(orderId);
+    }
+
+    // Choose the bins to pick an order from. One search from the depot gives
+    // the distance to every bin holding the item (the graph is undirected, so
+    // this is the multi-source search from the bins back to the depot); the
+    // depot's tree is cached, so after the first order it's just lookups. The nearest bin that can fill the whole order wins; otherwise the
+    // pick is split across bins, nearest first. The picked stock leaves the
+    // shelves and is recorded in order.picks; itemLocationNode becomes the
+    // nearest picked bin. Returns false, changing nothing, if the reachable
+    // bins can't cover the order.
+    bool assignBins(Order& order, WarehouseGraph& graph, InventoryManager& inv) {
+        vector<BinQuantity> bins;
+        if (!inv.getBins(order.itemId, bins) || bins.empty()) {
+            // Not stocked in any bin (e.g. item removed): route to the order's own location
+            return graph.getDistance(0, order.itemLocationNode) != -1;
+        }
+
+        vector<int> nodes;
+        for (const BinQuantity& b : bins) nodes.push_back(b.node);
+        vector<int> dist = graph.getTreeDistances(0, nodes);
+
+        vector<size_t> byDistance;
+        for (size_t i = 0; i < bins.size(); ++i) {
+            if (dist[i] != -1) byDistance.push_back(i);
+        }
+        sort(byDistance.begin(), byDistance.end(), [&](size_t a, size_t b) {
+            return dist[a] != dist[b] ? dist[a] < dist[b] : bins[a].node < bins[b].node;
         });
 
-        if (it != orderHeap.end()) {
-            // Remove from heap: swap with back, pop back, make_heap
-            orderHeap.erase(it);
-            make_heap(orderHeap.begin(), orderHeap.end());
-            return true;
+        vector<BinQuantity> picks;
+        for (size_t i : byDistance) {
+            if (bins[i].quantity >= order.quantity) {
+                picks.push_back({bins[i].node, order.quantity});
+                break;
+            }
         }
-        return false;
+        if (picks.empty()) {
+            int remaining = order.quantity;
+            for (size_t i : byDistance) {
+                if (remaining == 0) break;
+                int take = min(remaining, bins[i].quantity);
+                if (take <= 0) continue;
+                picks.push_back({bins[i].node, take});
+                remaining -= take;
+            }
+            if (remaining > 0 || picks.empty()) return false;
+        }
+
+        if (!inv.takeFromBins(order.itemId, picks)) return false;
+        order.picks = picks;
+        order.itemLocationNode = picks.front().node;
+        return true;
+    }
+
+    // assignBins over a batch, in ascending order ID. Waves and the pipeline
+    // use this so WAL replay (which only knows the IDs) picks the same bins.
+    vector<bool> assignBinsInIdOrder(vector<Order>& orders, WarehouseGraph& graph, InventoryManager& inv) {
+        vector<size_t> byId(orders.size());
+        for (size_t i = 0; i < orders.size(); ++i) byId[i] = i;
+        sort(byId.begin(), byId.end(), [&](size_t a, size_t b) { return orders[a].id < orders[b].id; });
+
+        vector<bool> assigned(orders.size());
+        for (size_t i : byId) assigned[i] = assignBins(orders[i], graph, inv);
+        return assigned;
+    }
+
+    // Put an order's picked stock back on the shelves
+    void returnPicks(Order& order, InventoryManager& inv) {
+        if (!order.picks.empty()) inv.returnToBins(order.itemId, order.picks);
+        order.picks.clear();
     }
 
-    void processNextOrder(WarehouseGraph& graph) {
+    // True if the top order was dispatched; on failure it stays pending
+    bool processNextOrder(WarehouseGraph& graph, InventoryManager& inv) {
         if (orderHeap.empty()) {
             cout << "No pending orders to process.\n";
-            return;
+            return false;
         }
 
         // Pop highest priority order
-        pop_heap(orderHeap.begin(), orderHeap.end());
-        Order currentOrder = orderHeap.back();
-        orderHeap.pop_back();
+        Order currentOrder = popPending();
 
         cout << "\nProcessing Order ID: " << currentOrder.id << " (Priority: " << currentOrder.priority << ")\n";
         
-        // Path Optimization (Graph)
-        pair<int, vector<int>> result = graph.getShortestPath(0, currentOrder.itemLocationNode);
-        
-        if (result.first != -1) {
-            dispatchQueue.push_back(currentOrder); // Push to dispatch
-            // Log isn't strictly needed here if we rely on main's "UNDO" command flow, 
-            // but for tracking PROCESS actions:
-             // historyLogger->logAction({...}); // Main.cpp will handle logging to capture state
-        } else {
-            cout << "Error: Unreachable item location!\n"; 
-            // Put it back?
-            orderHeap.push_back(currentOrder);
-            push_heap(orderHeap.begin(), orderHeap.end());
+        // Path Optimization (Graph) - nearest bin(s) with enough stock
+        if (assignBins(currentOrder, graph, inv)) {
+            pushDispatch(currentOrder); // Push to dispatch
+            return true;
+        }
+        cout << "Error: No reachable bin with enough stock!\n"; 
+        pushPending(currentOrder); // Put it back
+        return false;
+    }
+
+    // Pick wave: pop the top-k orders and route them as a single picker trip.
+    // Orders that can't be picked from any reachable bin go back into the heap.
+    WaveResult processWave(WarehouseGraph& graph, InventoryManager& inv, int k, int budgetMs = 20) {
+        WaveResult wave = {{}, {}, 0, 0};
+
+        vector<Order> popped;
+        while ((int)popped.size() < k && !orderHeap.empty()) {
+            popped.push_back(popPending());
+        }
+        if (popped.empty()) return wave;
+
+        vector<Order> picked;
+        vector<bool> assigned = assignBinsInIdOrder(popped, graph, inv);
+        for (size_t i = 0; i < popped.size(); ++i) {
+            if (assigned[i]) picked.push_back(popped[i]);
+            else pushPending(popped[i]);
+        }
+        if (picked.empty()) return wave;
+
+        // Distinct stops; index 0 is the depot. A split pick visits every bin it
+        // takes from; the order is counted at its nearest one (itemLocationNode).
+        vector<int> stops = {0};
+        for (const Order& o : picked) {
+            vector<int> nodes = {o.itemLocationNode};
+            for (const BinQuantity& b : o.picks) nodes.push_back(b.node);
+            for (int node : nodes) {
+                if (find(stops.begin(), stops.end(), node) == stops.end()) stops.push_back(node);
+            }
         }
+        vector<vector<int>> matrix = graph.getDistanceMatrix(stops);
+
+        // Drop stops the depot cannot reach
+        vector<int> reachable = {0};
+        for (size_t i = 1; i < stops.size(); ++i) {
+            if (matrix[0][i] != -1) reachable.push_back((int)i);
+        }
+        vector<vector<int>> sub(reachable.size(), vector<int>(reachable.size()));
+        for (size_t i = 0; i < reachable.size(); ++i) {
+            for (size_t j = 0; j < reachable.size(); ++j) {
+                sub[i][j] = matrix[reachable[i]][reachable[j]];
+            }
+        }
+
+        WavePlanner planner(sub);
+        vector<int> tour = planner.plan(budgetMs);
+        wave.tourDistance = planner.tourLength(tour);
+
+        // Solo-trip baseline: a round trip from the depot to every bin the order takes from
+        auto dispatchOrder = [&](const Order& o) {
+            wave.orders.push_back(o);
+            pushDispatch(o);
+            vector<int> nodes;
+            for (const BinQuantity& b : o.picks) nodes.push_back(b.node);
+            if (nodes.empty()) nodes.push_back(o.itemLocationNode);
+            for (int node : nodes) {
+                size_t pos = find(stops.begin(), stops.end(), node) - stops.begin();
+                wave.individualDistance += 2 * matrix[0][pos];
+            }
+        };
+
+        // Picked at the depot itself: ready before the picker leaves
+        for (const Order& o : picked) {
+            if (o.itemLocationNode == 0) dispatchOrder(o);
+        }
+        for (int idx : tour) {
+            int node = stops[reachable[idx]];
+            wave.tour.push_back(node);
+            if (idx == 0) continue;
+            for (const Order& o : picked) {
+                if (o.itemLocationNode == node) dispatchOrder(o);
+            }
+        }
+        return wave;
+    }
+
+    // --- Hooks for the staged pipeline (OrderPipeline) ---
+
+    // Pop the highest priority order for external routing
+    bool takeNextOrder(Order& out) {
+        if (orderHeap.empty()) return false;
+        out = popPending();
+        return true;
+    }
+
+    // Move specific pending orders straight to dispatch, in the given order
+    // (WAL replay of waves and pipeline batches). Bins are assigned the same
+    // way the original batch did. Returns the IDs actually moved.
+    vector<int> moveToDispatch(const vector<int>& orderIds, WarehouseGraph& graph, InventoryManager& inv) {
+        vector<Order> orders;
+        for (int id : orderIds) {
+            Order order;
+            if (removePending(id, &order)) orders.push_back(order);
+        }
+        vector<bool> assigned = assignBinsInIdOrder(orders, graph, inv);
+
+        vector<int> moved;
+        for (size_t i = 0; i < orders.size(); ++i) {
+            if (assigned[i]) {
+                pushDispatch(orders[i]);
+                moved.push_back(orders[i].id);
+            } else {
+                pushPending(orders[i]);
+            }
+        }
+        return moved;
+    }
+
+    // Accept an order routed elsewhere into the dispatch queue
+    void acceptRouted(const Order& order) {
+        pushDispatch(order);
     }
 
     void dispatchNextOrder() {
@@ -97,11 +349,12 @@ public:
 
         Order order = dispatchQueue.front();
         dispatchQueue.pop_front();
+        touch(DISPATCHED_ORDER, order.id);
         cout << "Dispatching Order ID: " << order.id << "\n";
     }
 
     // Undo Process: Move from Dispatch Back to Pending
-    bool revertProcess() {
+    bool revertProcess(InventoryManager& inv) {
         if (dispatchQueue.empty()) return false;
         
         // The last processed order is at the BACK of the dispatch queue? 
@@ -109,10 +362,11 @@ public:
         // So the most recently processed is at the back.
         Order last = dispatchQueue.back();
         dispatchQueue.pop_back();
+        touch(DISPATCHED_ORDER, last.id);
+        returnPicks(last, inv); // Stock goes back to the bins it was picked from
         
         // Put back into heap
-        orderHeap.push_back(last);
-        push_heap(orderHeap.begin(), orderHeap.end());
+        pushPending(last);
         return true;
     }
 
@@ -129,7 +383,7 @@ public:
             return;
         }
         // Copy to sort for display without destroying heap
-        vector<Order> temp = orderHeap;
+        vector<Order> temp = orderHeap.data();
         sort_heap(temp.begin(), temp.end()); // sorts in ascending, so reverse for desc priority
         
         cout << "\n--- Pending Orders (Priority (Heap)) ---\n";
@@ -140,17 +394,64 @@ public:
     }
 
     // --- Accessors for GUI/API Serialization ---
-    
-    vector<Order> getPendingOrders() {
-        // Return sorted list
-         vector<Order> temp = orderHeap;
-         sort_heap(temp.begin(), temp.end());
-         // sort_heap puts smallest at begin? No, max heap -> sort_heap -> sorted (ascending).
-         // So we need to reverse to show highest priority first.
-         reverse(temp.begin(), temp.end());
-         return temp;
+
+    // Highest priority pending order without copying anything (nullptr if none)
+    const Order* peekTop() const {
+        return orderHeap.empty() ? nullptr : &orderHeap.top();
     }
 
+    size_t pendingCount() const { return orderHeap.size(); }
+
+    // Pending orders in raw heap order (cheapest to re-insert; used by snapshots)
+    const vector<Order>& pendingHeapOrder() const { return orderHeap.data(); }
+
+    // Visit the k highest priority orders, best first, in O(k log k), without
+    // copying them. Walks the heap best-first: a child can only come out after
+    // its parent, so the frontier never holds more than k + 1 slots.
+    template <typename F>
+    void forEachTopK(size_t k, F visit) const {
+        const vector<Order>& heap = orderHeap.data();
+        k = min(k, heap.size());
+        if (k == 0) return;
+
+        auto lower = [&heap](size_t a, size_t b) { return heap[a] < heap[b]; };
+        priority_queue<size_t, vector<size_t>, decltype(lower)> frontier(lower);
+        frontier.push(0);
+
+        for (size_t emitted = 0; emitted < k; ++emitted) {
+            size_t i = frontier.top();
+            frontier.pop();
+            visit(heap[i]);
+            if (2 * i + 1 < heap.size()) frontier.push(2 * i + 1);
+            if (2 * i + 2 < heap.size()) frontier.push(2 * i + 2);
+        }
+    }
+
+    // The k highest priority orders, best first
+    vector<Order> topK(size_t k) const {
+        vector<Order> result;
+        result.reserve(min(k, orderHeap.size()));
+        forEachTopK(k, [&result](const Order& o) { result.push_back(o); });
+        return result;
+    }
+
+    // One page of the pending list in priority order
+    vector<Order> getPendingOrders(size_t offset, size_t limit) const {
+        if (offset >= orderHeap.size()) return {};
+        limit = min(limit, orderHeap.size() - offset); // Client-supplied: offset + limit may overflow
+        vector<Order> page = topK(offset + limit);
+        page.erase(page.begin(), page.begin() + offset);
+        return page;
+    }
+
+    // Full pending list, highest priority first
+    vector<Order> getPendingOrders() const {
+        return topK(orderHeap.size());
+    }
+
+    // Dispatch queue in FIFO order, for serializers that read it in place
+    const deque<Order>& dispatchedOrders() const { return dispatchQueue; }
+
     vector<Order> getDispatchedOrders() {
         vector<Order> list;
         for(const auto& o : dispatchQueue) {
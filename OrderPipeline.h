@@ -0,0 +1,206 @@
+#ifndef ORDERPIPELINE_H
+#define ORDERPIPELINE_H
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <queue>
+#include <memory>
+#include "Order.h"
+#include "WarehouseGraph.h"
+#include "LockFreeQueue.h"
+
+using namespace std;
+
+// An order after the routing stage
+struct RoutedOrder {
+    long long seq;      // Intake sequence number
+    Order order;
+    int distance;       // -1 if the location is unreachable
+    vector<int> path;
+};
+
+// Queue depths and counters, readable while the pipeline runs
+struct PipelineStats {
+    size_t intakeDepth;     // Orders waiting for a routing worker
+    size_t dispatchDepth;   // Routed orders waiting for the dispatch stage
+    long long submitted;
+    long long routed;
+    long long dispatched;
+    long long intakeStalls; // Submits that had to wait for space (backpressure)
+    long long routeStalls;  // Routed orders that had to wait for the dispatch stage
+};
+
+// Staged order pipeline: intake -> routing workers -> dispatch.
+//
+// - Intake (the caller's thread) submits orders into a bounded MPMC queue.
+// - A pool of routing workers pops them and computes depot paths in parallel
+//   through WarehouseGraph::findPath, which is read-only. The graph must not be
+//   changed while the pipeline runs.
+// - Each worker hands its results to the dispatch stage through its own SPSC
+//   queue. The dispatch thread restores intake order and passes every order
+//   to the sink callback, which always runs on that one thread.
+//
+// Full queues block the producer (yield, then short sleeps), so a slow stage
+// throttles the ones before it instead of growing memory.
+class OrderPipeline {
+private:
+    const WarehouseGraph& graph;
+    function<void(RoutedOrder&)> sink;
+
+    MpmcQueue<RoutedOrder> intake;
+    vector<unique_ptr<SpscQueue<RoutedOrder>>> routedQueues; // One per worker
+
+    vector<thread> workers;
+    thread dispatcher;
+
+    atomic<bool> intakeClosed;
+    atomic<int> workersRunning;
+    atomic<long long> submitted, routed, dispatched, intakeStalls, routeStalls;
+    long long nextSeq = 0;      // Intake thread only
+    long long nextDispatch = 0; // Dispatch thread only
+    bool running = false;
+
+    // Spin briefly, then sleep, so idle stages don't burn a core
+    static void backoff(int& spins) {
+        if (++spins < 64) this_thread::yield();
+        else this_thread::sleep_for(chrono::microseconds(50));
+    }
+
+    void routingWorker(size_t index) {
+        SpscQueue<RoutedOrder>& out = *routedQueues[index];
+        RoutedOrder job;
+        int spins = 0;
+        while (true) {
+            if (!intake.tryPop(job)) {
+                if (intakeClosed.load(memory_order_acquire) && intake.sizeApprox() == 0) break;
+                backoff(spins);
+                continue;
+            }
+            spins = 0;
+
+            pair<int, vector<int>> result = graph.findPath(0, job.order.itemLocationNode);
+            job.distance = result.first;
+            job.path.swap(result.second);
+            routed.fetch_add(1, memory_order_relaxed);
+
+            bool stalled = false;
+            int pushSpins = 0;
+            while (!out.tryPush(std::move(job))) {
+                stalled = true;
+                backoff(pushSpins);
+            }
+            if (stalled) routeStalls.fetch_add(1, memory_order_relaxed);
+        }
+        workersRunning.fetch_sub(1, memory_order_release);
+    }
+
+    void dispatchStage() {
+        // Reorder buffer: workers finish out of order, the sink sees intake order
+        auto later = [](const RoutedOrder& a, const RoutedOrder& b) { return a.seq > b.seq; };
+        priority_queue<RoutedOrder, vector<RoutedOrder>, decltype(later)> pendingOut(later);
+        RoutedOrder item;
+        int spins = 0;
+
+        while (true) {
+            bool workersDone = workersRunning.load(memory_order_acquire) == 0;
+            bool got = false;
+            for (auto& q : routedQueues) {
+                while (q->tryPop(item)) {
+                    pendingOut.push(std::move(item));
+                    got = true;
+                }
+            }
+            while (!pendingOut.empty() && pendingOut.top().seq == nextDispatch) {
+                RoutedOrder next = pendingOut.top();
+                pendingOut.pop();
+                sink(next);
+                ++nextDispatch;
+                dispatched.fetch_add(1, memory_order_release);
+            }
+            if (got) {
+                spins = 0;
+            } else if (workersDone) {
+                break; // Workers exited before this pass started, so every queue is drained
+            } else {
+                backoff(spins);
+            }
+        }
+    }
+
+public:
+    OrderPipeline(const WarehouseGraph& g, function<void(RoutedOrder&)> onDispatch,
+                  size_t workerCount = thread::hardware_concurrency(), size_t queueCapacity = 1024)
+        : graph(g), sink(onDispatch), intake(queueCapacity),
+          intakeClosed(false), workersRunning(0),
+          submitted(0), routed(0), dispatched(0), intakeStalls(0), routeStalls(0) {
+        if (workerCount == 0) workerCount = 1;
+        for (size_t i = 0; i < workerCount; ++i) {
+            routedQueues.emplace_back(new SpscQueue<RoutedOrder>(queueCapacity));
+        }
+    }
+
+    ~OrderPipeline() {
+        shutdown();
+    }
+
+    void start() {
+        if (running) return;
+        running = true;
+        intakeClosed.store(false);
+        workersRunning.store((int)routedQueues.size());
+        for (size_t i = 0; i < routedQueues.size(); ++i) {
+            workers.emplace_back(&OrderPipeline::routingWorker, this, i);
+        }
+        dispatcher = thread(&OrderPipeline::dispatchStage, this);
+    }
+
+    // Intake stage: blocks while the routing queue is full. Single caller thread.
+    void submit(const Order& order) {
+        RoutedOrder job;
+        job.seq = nextSeq++;
+        job.order = order;
+        job.distance = -1;
+
+        bool stalled = false;
+        int spins = 0;
+        while (!intake.tryPush(std::move(job))) {
+            stalled = true;
+            backoff(spins);
+        }
+        if (stalled) intakeStalls.fetch_add(1, memory_order_relaxed);
+        submitted.fetch_add(1, memory_order_relaxed);
+    }
+
+    // Wait until every submitted order has reached the sink
+    void waitIdle() {
+        int spins = 0;
+        while (dispatched.load(memory_order_acquire) < submitted.load(memory_order_relaxed)) {
+            backoff(spins);
+        }
+    }
+
+    // Drain everything already submitted, then stop all stages
+    void shutdown() {
+        if (!running) return;
+        intakeClosed.store(true, memory_order_release);
+        for (auto& w : workers) w.join();
+        workers.clear();
+        dispatcher.join();
+        running = false;
+    }
+
+    size_t workerCount() const { return routedQueues.size(); }
+
+    PipelineStats stats() const {
+        size_t dispatchDepth = 0;
+        for (auto& q : routedQueues) dispatchDepth += q->sizeApprox();
+        return {intake.sizeApprox(), dispatchDepth,
+                submitted.load(), routed.load(), dispatched.load(),
+                intakeStalls.load(), routeStalls.load()};
+    }
+};
+
+#endif
@@ -0,0 +1,329 @@
+#ifndef PERSISTENTMAP_H
+#define PERSISTENTMAP_H
+
+#include <memory>
+#include <vector>
+#include <utility>
+#include <functional> // less
+#include <cstddef>
+
+using namespace std;
+
+// Ordered map whose updates never modify existing nodes (a persistent B+ tree).
+// insert/erase copy only the handful of nodes on the path to the key and
+// share the rest, so copying the map is O(1) and every copy is an
+// independent, immutable version. Nodes are reference counted: a version a
+// reader still holds stays intact, and nodes no version uses any more are
+// freed when the last one goes.
+//
+// One writer may update a map while any number of threads read other copies
+// of it. Subtree sizes are kept, so iteration can start at a rank.
+// K and V must be default-constructible (unused slots hold K() / V()).
+template <typename K, typename V, typename Less = less<K>>
+class PersistentMap {
+private:
+    static const int FANOUT = 16;          // Entries per leaf, children per inner node
+    static const int MIN_FILL = FANOUT / 4; // Smaller nodes get merged into a neighbour
+
+    struct Node;
+    typedef shared_ptr<const Node> Ptr;
+
+    // One spare slot: a node may hold FANOUT + 1 for a moment before it splits
+    struct Node {
+        bool leaf;
+        int count = 0;
+        size_t size = 0;         // Entries in the subtree
+        K keys[FANOUT + 1];      // Leaf: the entries' keys. Inner: keys[i] <= every key under child i,
+                                 // and every key under child i - 1 is before keys[i]
+        explicit Node(bool isLeaf) : leaf(isLeaf) {}
+    };
+
+    struct Leaf : Node {
+        V values[FANOUT + 1];
+        Leaf() : Node(true) {}
+    };
+
+    struct Inner : Node {
+        Ptr children[FANOUT + 1];
+        Inner() : Node(false) {}
+    };
+
+    Ptr root;
+
+    static const Leaf& asLeaf(const Node& n) { return static_cast<const Leaf&>(n); }
+    static const Inner& asInner(const Node& n) { return static_cast<const Inner&>(n); }
+
+    // First entry not before 'key'
+    static int lowerBound(const Node& n, const K& key) {
+        Less less;
+        int lo = 0, hi = n.count;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (less(n.keys[mid], key)) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    // Child whose range holds 'key'
+    static int childIndex(const Inner& n, const K& key) {
+        Less less;
+        int lo = 1, hi = n.count;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (less(key, n.keys[mid])) hi = mid;
+            else lo = mid + 1;
+        }
+        return lo - 1;
+    }
+
+    // Move entries [from, count) of an overfull node into a new right sibling
+    static Ptr splitLeaf(Leaf& left) {
+        shared_ptr<Leaf> right = make_shared<Leaf>();
+        int from = left.count / 2;
+        for (int i = from; i < left.count; ++i) {
+            right->keys[i - from] = left.keys[i];
+            right->values[i - from] = std::move(left.values[i]);
+            left.keys[i] = K();
+            left.values[i] = V();
+        }
+        right->count = right->size = left.count - from;
+        left.count = left.size = from;
+        return right;
+    }
+
+    static Ptr splitInner(Inner& left) {
+        shared_ptr<Inner> right = make_shared<Inner>();
+        int from = left.count / 2;
+        for (int i = from; i < left.count; ++i) {
+            right->keys[i - from] = left.keys[i];
+            right->children[i - from] = std::move(left.children[i]);
+            right->size += right->children[i - from]->size;
+            left.keys[i] = K();
+        }
+        right->count = left.count - from;
+        left.count = from;
+        left.size -= right->size;
+        return right;
+    }
+
+    // Copy of 'n' with 'key' set; 'split' gets the upper half if the copy overflowed
+    static Ptr insertAt(const Node& n, const K& key, const V& value, bool& added, Ptr& split) {
+        Less less;
+        if (n.leaf) {
+            shared_ptr<Leaf> copy = make_shared<Leaf>(asLeaf(n));
+            int i = lowerBound(n, key);
+            if (i < n.count && !less(key, n.keys[i])) {
+                copy->values[i] = value;
+                added = false;
+                return copy;
+            }
+            for (int j = copy->count; j > i; --j) {
+                copy->keys[j] = copy->keys[j - 1];
+                copy->values[j] = std::move(copy->values[j - 1]);
+            }
+            copy->keys[i] = key;
+            copy->values[i] = value;
+            copy->size = ++copy->count;
+            added = true;
+            if (copy->count > FANOUT) split = splitLeaf(*copy);
+            return copy;
+        }
+
+        const Inner& old = asInner(n);
+        int c = childIndex(old, key);
+        Ptr childSplit;
+        Ptr child = insertAt(*old.children[c], key, value, added, childSplit);
+        shared_ptr<Inner> copy = make_shared<Inner>(old);
+        copy->children[c] = std::move(child);
+        if (added) ++copy->size;
+        if (childSplit) {
+            for (int j = copy->count; j > c + 1; --j) {
+                copy->keys[j] = copy->keys[j - 1];
+                copy->children[j] = std::move(copy->children[j - 1]);
+            }
+            copy->keys[c + 1] = childSplit->keys[0];
+            copy->children[c + 1] = std::move(childSplit);
+            ++copy->count;
+            if (copy->count > FANOUT) split = splitInner(*copy);
+        }
+        return copy;
+    }
+
+    // One node holding both neighbours' entries (they fit in FANOUT)
+    static Ptr concat(const Node& a, const Node& b) {
+        if (a.leaf) {
+            shared_ptr<Leaf> joined = make_shared<Leaf>(asLeaf(a));
+            for (int i = 0; i < b.count; ++i) {
+                joined->keys[a.count + i] = b.keys[i];
+                joined->values[a.count + i] = asLeaf(b).values[i];
+            }
+            joined->count = a.count + b.count;
+            joined->size = joined->count;
+            return joined;
+        }
+        shared_ptr<Inner> joined = make_shared<Inner>(asInner(a));
+        for (int i = 0; i < b.count; ++i) {
+            joined->keys[a.count + i] = b.keys[i];
+            joined->children[a.count + i] = asInner(b).children[i];
+        }
+        joined->count = a.count + b.count;
+        joined->size = a.size + b.size;
+        return joined;
+    }
+
+    // Copy of 'n' without 'key' (known to be present); may come back empty
+    static Ptr eraseAt(const Node& n, const K& key) {
+        if (n.leaf) {
+            shared_ptr<Leaf> copy = make_shared<Leaf>(asLeaf(n));
+            int i = lowerBound(n, key);
+            for (int j = i; j + 1 < copy->count; ++j) {
+                copy->keys[j] = copy->keys[j + 1];
+                copy->values[j] = std::move(copy->values[j + 1]);
+            }
+            --copy->count;
+            copy->keys[copy->count] = K();
+            copy->values[copy->count] = V();
+            copy->size = copy->count;
+            return copy;
+        }
+
+        const Inner& old = asInner(n);
+        int c = childIndex(old, key);
+        Ptr child = eraseAt(*old.children[c], key);
+        shared_ptr<Inner> copy = make_shared<Inner>(old);
+        --copy->size;
+        int removeAt = -1;
+        if (child->count == 0) {
+            removeAt = c;
+        } else if (child->count < MIN_FILL && copy->count > 1) {
+            // Fold into a neighbour if the two fit in one node
+            int left = c + 1 < copy->count ? c : c - 1;
+            const Node& a = left == c ? *child : *copy->children[left];
+            const Node& b = left == c ? *copy->children[c + 1] : *child;
+            if (a.count + b.count <= FANOUT) {
+                copy->children[left] = concat(a, b);
+                removeAt = left + 1;
+            } else {
+                copy->children[c] = std::move(child);
+            }
+        } else {
+            copy->children[c] = std::move(child);
+        }
+        if (removeAt >= 0) {
+            // keys[0] stays: it is the bound the parent routes by
+            for (int j = removeAt; j + 1 < copy->count; ++j) {
+                if (j > 0) copy->keys[j] = copy->keys[j + 1];
+                copy->children[j] = std::move(copy->children[j + 1]);
+            }
+            --copy->count;
+            copy->keys[copy->count] = K();
+            copy->children[copy->count] = nullptr;
+        }
+        return copy;
+    }
+
+    template <typename F>
+    static bool visit(const Node& n, size_t& skip, size_t& limit, F& f) {
+        if (n.leaf) {
+            const Leaf& leaf = asLeaf(n);
+            int i = (int)skip;
+            skip = 0;
+            for (; i < n.count; ++i) {
+                f(n.keys[i], leaf.values[i]);
+                if (--limit == 0) return false;
+            }
+            return true;
+        }
+        const Inner& inner = asInner(n);
+        for (int i = 0; i < n.count; ++i) {
+            const Node& child = *inner.children[i];
+            if (skip >= child.size) {
+                skip -= child.size;
+                continue;
+            }
+            if (!visit(child, skip, limit, f)) return false;
+        }
+        return true;
+    }
+
+public:
+    size_t size() const { return root ? root->size : 0; }
+    bool empty() const { return size() == 0; }
+
+    const V* find(const K& key) const {
+        Less less;
+        const Node* n = root.get();
+        while (n && !n->leaf) n = asInner(*n).children[childIndex(asInner(*n), key)].get();
+        if (!n) return nullptr;
+        int i = lowerBound(*n, key);
+        if (i < n->count && !less(key, n->keys[i])) return &asLeaf(*n).values[i];
+        return nullptr;
+    }
+
+    // Insert or replace
+    void insert(const K& key, const V& value) {
+        if (!root) root = make_shared<Leaf>();
+        bool added = false;
+        Ptr split;
+        Ptr top = insertAt(*root, key, value, added, split);
+        if (split) {
+            shared_ptr<Inner> grown = make_shared<Inner>();
+            grown->keys[0] = top->keys[0];
+            grown->keys[1] = split->keys[0];
+            grown->size = top->size + split->size;
+            grown->children[0] = std::move(top);
+            grown->children[1] = std::move(split);
+            grown->count = 2;
+            top = std::move(grown);
+        }
+        root = std::move(top);
+    }
+
+    void erase(const K& key) {
+        if (!find(key)) return;
+        root = eraseAt(*root, key);
+        while (root && !root->leaf && root->count == 1) root = asInner(*root).children[0];
+        if (root && root->count == 0) root = nullptr;
+    }
+
+    void clear() { root = nullptr; }
+
+    // f(key, value) in key order, skipping the first 'offset' entries, at most 'limit' calls
+    template <typename F>
+    void forEach(F f, size_t offset = 0, size_t limit = (size_t)-1) const {
+        if (!root || limit == 0 || offset >= root->size) return;
+        visit(*root, offset, limit, f);
+    }
+
+    // Replace the contents with entries already in key order, packed bottom-up
+    void assignSorted(const vector<pair<K, V>>& entries) {
+        vector<Ptr> level;
+        for (size_t i = 0; i < entries.size(); i += FANOUT) {
+            shared_ptr<Leaf> leaf = make_shared<Leaf>();
+            for (size_t j = i; j < entries.size() && j < i + FANOUT; ++j) {
+                leaf->keys[leaf->count] = entries[j].first;
+                leaf->values[leaf->count] = entries[j].second;
+                ++leaf->count;
+            }
+            leaf->size = leaf->count;
+            level.push_back(std::move(leaf));
+        }
+        while (level.size() > 1) {
+            vector<Ptr> parents;
+            for (size_t i = 0; i < level.size(); i += FANOUT) {
+                shared_ptr<Inner> inner = make_shared<Inner>();
+                for (size_t j = i; j < level.size() && j < i + FANOUT; ++j) {
+                    inner->keys[inner->count] = level[j]->keys[0];
+                    inner->size += level[j]->size;
+                    inner->children[inner->count++] = std::move(level[j]);
+                }
+                parents.push_back(std::move(inner));
+            }
+            level.swap(parents);
+        }
+        root = level.empty() ? nullptr : std::move(level[0]);
+    }
+};
+
+#endif
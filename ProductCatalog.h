@@ -3,89 +3,356 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include "ArenaPool.h"
+#include "ChangeJournal.h"
 
 using namespace std;
 
+// One product. (The name dates from when the catalog was a binary tree of
+// these; the ID index is now a separate B+ tree pointing at them.)
 struct BSTNode {
     int productId;
     string productName;
-    string category;
+    const string* category; // Interned: shared by every product in the category
     double price;
-    BSTNode* left;
-    BSTNode* right;
 
-    BSTNode(int id, string name, string cat, double p) 
-        : productId(id), productName(name), category(cat), price(p), left(nullptr), right(nullptr) {}
+    BSTNode(int id, const string& name, const string* cat, double p)
+        : productId(id), productName(name), category(cat), price(p) {}
 };
 
-// Manages product data using a Binary Search Tree (BST) for sorted storage and efficient search
+// One catalog row as parsed from a file; the views point into the file buffer
+struct ProductRecord {
+    int id;
+    string_view name;
+    string_view category;
+    double price;
+};
+
+// Manages product data, sorted by ID, in a B+ tree with wide nodes: each node
+// keeps up to FANOUT IDs side by side, so a lookup reads a few contiguous key
+// arrays (about log64(n) nodes) instead of chasing one pointer per level of a
+// binary tree. Leaves are chained in ID order for range scans and listings.
+// Products are never removed, so products and index nodes all live in arenas.
 class ProductCatalog {
 private:
-    BSTNode* root;
+    static const int FANOUT = 64; // IDs per node: 256 bytes of keys, four cache lines
 
-    // Helper: Recursive Insert
-    BSTNode* insert(BSTNode* node, int id, string name, string cat, double price) {
-        if (node == nullptr) {
-            return new BSTNode(id, name, cat, price);
-        }
-        if (id < node->productId) {
-            node->left = insert(node->left, id, name, cat, price);
-        } else if (id > node->productId) {
-            node->right = insert(node->right, id, name, cat, price);
+    struct IndexNode {
+        bool leaf;
+        int count = 0;
+        int keys[FANOUT];  // Leaf: product IDs. Inner: keys[i] = smallest ID under child i
+        explicit IndexNode(bool isLeaf) : leaf(isLeaf) {}
+    };
+
+    struct Leaf : IndexNode {
+        BSTNode* products[FANOUT];
+        Leaf* next = nullptr; // Next leaf in ID order
+        Leaf() : IndexNode(true) {}
+    };
+
+    struct Inner : IndexNode {
+        IndexNode* children[FANOUT];
+        Inner() : IndexNode(false) {}
+    };
+
+    IndexNode* root = nullptr;
+    Leaf* firstLeaf = nullptr;
+    int levels = 0;
+    ChangeJournal* journal = nullptr; // Optional, for delta state queries
+
+    // Products and index nodes live in arenas: one allocation per block, all
+    // freed with the catalog
+    ArenaPool<BSTNode> nodePool;
+    ArenaPool<Leaf, 64> leafPool;
+    ArenaPool<Inner, 16> innerPool;
+
+    // Interned category names (a few dozen shared by the whole catalog).
+    // unordered_set never moves its elements, so the pointers stay valid.
+    unordered_set<string> categoryNames;
+
+    // Secondary index: interned category -> products, sorted by ID
+    unordered_map<const string*, vector<const BSTNode*>> byCategory;
+
+    const string* intern(const string& cat) {
+        return &*categoryNames.insert(cat).first;
+    }
+
+    static Leaf* asLeaf(IndexNode* n) { return static_cast<Leaf*>(n); }
+    static Inner* asInner(IndexNode* n) { return static_cast<Inner*>(n); }
+
+    // Number of leading keys[0, count) for which below(key) holds. Binary
+    // search without branches on the keys (the compiler turns the ternary into
+    // a conditional move), so a lookup doesn't pay a mispredict per halving.
+    template <typename Below>
+    static int countBelow(const int* keys, int count, Below below) {
+        if (count == 0) return 0;
+        const int* base = keys;
+        while (count > 1) {
+            int half = count / 2;
+            base = below(base[half]) ? base + half : base;
+            count -= half;
         }
-        return node;
+        return (int)(base - keys) + (below(*base) ? 1 : 0);
+    }
+
+    // First key not below 'id'
+    static int lowerBound(const IndexNode* n, int id) {
+        return countBelow(n->keys, n->count, [id](int key) { return key < id; });
+    }
+
+    // Child whose range holds 'id' (child 0 also takes IDs below every key)
+    static int childIndex(const IndexNode* n, int id) {
+        return countBelow(n->keys + 1, n->count - 1, [id](int key) { return key <= id; });
+    }
+
+    Leaf* findLeaf(int id) const {
+        IndexNode* n = root;
+        while (n && !n->leaf) n = asInner(n)->children[childIndex(n, id)];
+        return asLeaf(n);
     }
 
-    // Helper: Recursive Search
-    BSTNode* search(BSTNode* node, int id) {
-        if (node == nullptr || node->productId == id) {
-            return node;
+    // Where a full node splits: halves, except that an append to the right
+    // edge of the tree (sequential IDs) leaves the old node full
+    static int splitPoint(int pos, bool rightEdge) {
+        return pos == FANOUT && rightEdge ? FANOUT : FANOUT / 2;
+    }
+
+    // Insert into the subtree under 'n'. Returns the new right sibling if 'n'
+    // split; 'created' stays null for a duplicate ID.
+    IndexNode* insertAt(IndexNode* n, int id, const string& name, const string& cat, double price,
+                        bool rightEdge, BSTNode*& created) {
+        if (n->leaf) {
+            Leaf* leaf = asLeaf(n);
+            int pos = lowerBound(leaf, id);
+            if (pos < leaf->count && leaf->keys[pos] == id) return nullptr;
+            created = nodePool.create(id, name, intern(cat), price);
+
+            Leaf* split = nullptr;
+            if (leaf->count == FANOUT) {
+                int from = splitPoint(pos, rightEdge);
+                split = leafPool.create();
+                moveUpper(leaf, split, from);
+                split->next = leaf->next;
+                leaf->next = split;
+                if (pos > from || (pos == from && from == FANOUT)) {
+                    leaf = split;
+                    pos -= from;
+                }
+            }
+            for (int j = leaf->count; j > pos; --j) {
+                leaf->keys[j] = leaf->keys[j - 1];
+                leaf->products[j] = leaf->products[j - 1];
+            }
+            leaf->keys[pos] = id;
+            leaf->products[pos] = created;
+            ++leaf->count;
+            return split;
+        }
+
+        Inner* inner = asInner(n);
+        int c = childIndex(inner, id);
+        IndexNode* childSplit = insertAt(inner->children[c], id, name, cat, price,
+                                         rightEdge && c == inner->count - 1, created);
+        inner->keys[c] = inner->children[c]->keys[0]; // A new smallest ID lands in child 0
+        if (!childSplit) return nullptr;
+
+        int pos = c + 1;
+        Inner* split = nullptr;
+        if (inner->count == FANOUT) {
+            int from = splitPoint(pos, rightEdge);
+            split = innerPool.create();
+            moveUpper(inner, split, from);
+            if (pos > from || (pos == from && from == FANOUT)) {
+                inner = split;
+                pos -= from;
+            }
         }
-        if (id < node->productId) {
-            return search(node->left, id);
+        for (int j = inner->count; j > pos; --j) {
+            inner->keys[j] = inner->keys[j - 1];
+            inner->children[j] = inner->children[j - 1];
         }
-        return search(node->right, id);
+        inner->keys[pos] = childSplit->keys[0];
+        inner->children[pos] = childSplit;
+        ++inner->count;
+        return split;
     }
 
-    // Helper: In-order traversal
-    void inorder(BSTNode* node) {
-        if (node != nullptr) {
-            inorder(node->left);
-            cout << "ID: " << node->productId << " | Name: " << node->productName 
-                 << " | Category: " << node->category << " | Price: $" << node->price << endl;
-            inorder(node->right);
+    // Entries [from, count) of a full node move to its new right sibling
+    static void moveUpper(Leaf* left, Leaf* right, int from) {
+        for (int i = from; i < left->count; ++i) {
+            right->keys[i - from] = left->keys[i];
+            right->products[i - from] = left->products[i];
         }
+        right->count = left->count - from;
+        left->count = from;
+    }
+
+    static void moveUpper(Inner* left, Inner* right, int from) {
+        for (int i = from; i < left->count; ++i) {
+            right->keys[i - from] = left->keys[i];
+            right->children[i - from] = left->children[i];
+        }
+        right->count = left->count - from;
+        left->count = from;
+    }
+
+    void indexCategory(const BSTNode* node) {
+        vector<const BSTNode*>& list = byCategory[node->category];
+        auto pos = lower_bound(list.begin(), list.end(), node->productId,
+                               [](const BSTNode* n, int id) { return n->productId < id; });
+        list.insert(pos, node); // Sequential IDs append at the end
     }
 
 public:
-    ProductCatalog() : root(nullptr) {}
+    ProductCatalog() {}
+
+    // The catalog owns its nodes (through the arenas); copying would alias them
+    ProductCatalog(const ProductCatalog&) = delete;
+    ProductCatalog& operator=(const ProductCatalog&) = delete;
+
+    void setJournal(ChangeJournal* j) { journal = j; }
 
     void addProduct(int id, string name, string cat, double price) {
-        root = insert(root, id, name, cat, price);
+        BSTNode* created = nullptr;
+        if (!root) {
+            firstLeaf = leafPool.create();
+            root = firstLeaf;
+            levels = 1;
+        }
+        IndexNode* split = insertAt(root, id, name, cat, price, true, created);
+        if (split) {
+            Inner* grown = innerPool.create();
+            grown->keys[0] = root->keys[0];
+            grown->children[0] = root;
+            grown->keys[1] = split->keys[0];
+            grown->children[1] = split;
+            grown->count = 2;
+            root = grown;
+            ++levels;
+        }
+        if (created) indexCategory(created);
+        if (journal) journal->record(CATALOG_PRODUCT, id);
     }
 
+    // Bulk load (catalog files). Into an empty catalog this sorts once and packs
+    // full leaves, then each inner level, bottom-up in O(n) instead of n
+    // inserts; otherwise it falls back to addProduct. As with addProduct, the
+    // first row for an ID wins.
+    void addProducts(vector<ProductRecord>& records) {
+        if (root != nullptr) {
+            for (const ProductRecord& r : records) {
+                addProduct(r.id, string(r.name), string(r.category), r.price);
+            }
+            return;
+        }
+
+        stable_sort(records.begin(), records.end(),
+                    [](const ProductRecord& a, const ProductRecord& b) { return a.id < b.id; });
+
+        // Category names repeat on almost every row; intern each distinct one once
+        unordered_map<string_view, const string*> interned;
+        vector<IndexNode*> level;
+        Leaf* leaf = nullptr;
+        for (size_t i = 0; i < records.size(); ++i) {
+            const ProductRecord& r = records[i];
+            if (i > 0 && records[i - 1].id == r.id) continue;
+            auto cat = interned.find(r.category);
+            if (cat == interned.end()) cat = interned.emplace(r.category, intern(string(r.category))).first;
+            BSTNode* node = nodePool.create(r.id, string(r.name), cat->second, r.price);
+
+            if (!leaf || leaf->count == FANOUT) {
+                Leaf* fresh = leafPool.create();
+                if (leaf) leaf->next = fresh;
+                else firstLeaf = fresh;
+                leaf = fresh;
+                level.push_back(leaf);
+            }
+            leaf->keys[leaf->count] = r.id;
+            leaf->products[leaf->count++] = node;
+            byCategory[node->category].push_back(node); // Already in ID order
+            if (journal) journal->record(CATALOG_PRODUCT, r.id);
+        }
+        if (level.empty()) return;
+
+        levels = 1;
+        while (level.size() > 1) {
+            vector<IndexNode*> parents;
+            for (size_t i = 0; i < level.size(); i += FANOUT) {
+                Inner* inner = innerPool.create();
+                for (size_t j = i; j < level.size() && j < i + FANOUT; ++j) {
+                    inner->keys[inner->count] = level[j]->keys[0];
+                    inner->children[inner->count++] = level[j];
+                }
+                parents.push_back(inner);
+            }
+            level.swap(parents);
+            ++levels;
+        }
+        root = level[0];
+    }
+
+    // One root-to-leaf descent, O(log n) with a handful of node reads
     BSTNode* findProduct(int id) {
-        return search(root, id);
+        Leaf* leaf = findLeaf(id);
+        if (!leaf) return nullptr;
+        int pos = lowerBound(leaf, id);
+        return pos < leaf->count && leaf->keys[pos] == id ? leaf->products[pos] : nullptr;
+    }
+
+    // Products with lo <= ID <= hi, in ID order
+    vector<const BSTNode*> rangeById(int lo, int hi) const {
+        vector<const BSTNode*> result;
+        if (lo > hi) return result;
+        for (Leaf* leaf = findLeaf(lo); leaf; leaf = leaf->next) {
+            for (int i = lowerBound(leaf, lo); i < leaf->count; ++i) {
+                if (leaf->keys[i] > hi) return result;
+                result.push_back(leaf->products[i]);
+            }
+        }
+        return result;
+    }
+
+    // Products in one category, in ID order
+    const vector<const BSTNode*>& productsInCategory(const string& cat) const {
+        static const vector<const BSTNode*> none;
+        auto name = categoryNames.find(cat);
+        if (name == categoryNames.end()) return none;
+        return byCategory.at(&*name);
     }
 
+    size_t size() const { return nodePool.size(); }
+    size_t categoryCount() const { return categoryNames.size(); }
+
+    int treeHeight() const { return levels; }
+
     void displayCatalog() {
-        cout << "\n--- Product Catalog (BST In-Order Traversal) ---\n";
-        inorder(root);
-        cout << "------------------------------------------------\n";
+        cout << "\n--- Product Catalog (B+ Tree, ID Order) ---\n";
+        forEachProduct([](const BSTNode& p) {
+            cout << "ID: " << p.productId << " | Name: " << p.productName
+                 << " | Category: " << *p.category << " | Price: $" << p.price << endl;
+        });
+        cout << "-------------------------------------------\n";
     }
 
     // --- Accessor for GUI ---
-    void collectNodes(BSTNode* node, vector<BSTNode>& list) {
-        if (node != nullptr) {
-            collectNodes(node->left, list);
-            list.push_back(*node); // Copy node data
-            collectNodes(node->right, list);
+    // Visit every product in ID order without building a list
+    template <typename F>
+    void forEachProduct(F visit) const {
+        for (const Leaf* leaf = firstLeaf; leaf; leaf = leaf->next) {
+            for (int i = 0; i < leaf->count; ++i) visit(*leaf->products[i]);
         }
     }
 
-    vector<BSTNode> getCatalog() {
-        vector<BSTNode> list;
-        collectNodes(root, list);
+    // Views into the catalog, not copies: valid as long as the catalog lives
+    vector<const BSTNode*> getCatalog() const {
+        vector<const BSTNode*> list;
+        list.reserve(nodePool.size());
+        forEachProduct([&list](const BSTNode& p) { list.push_back(&p); });
         return list;
     }
 };
@@ -0,0 +1,86 @@
+#ifndef STATEJSON_H
+#define STATEJSON_H
+
+#include <iostream>
+#include <vector>
+#include "JsonWriter.h"
+#include "Order.h"
+#include "InventoryManager.h"
+#include "ProductCatalog.h"
+
+using namespace std;
+
+// JSON serialization for API mode: where responses go, and how each entity is
+// written. Whole-state responses (GET_STATE, GET_STATE_SINCE) are assembled by
+// StateSerializer.
+
+// Where API responses go: cout, unless the calling thread has pointed its slot
+// at its own buffer (HTTP mode answers requests on several worker threads)
+inline ostream*& apiOutSlot() {
+    thread_local ostream* out = &cout;
+    return out;
+}
+
+inline ostream& apiOut() {
+    return *apiOutSlot();
+}
+
+// Per-entity JSON writers, shared by full snapshots, deltas and the paged queries
+inline void writePendingOrderJSON(JsonWriter& w, const Order& o) {
+    w.raw("{\"id\": ").integer(o.id)
+     .raw(", \"text\": \"Item: ").escaped(o.itemName).raw(" (Prio: ").integer(o.priority).raw(")\"")
+     .raw(", \"prio\": ").integer(o.priority).raw('}');
+}
+
+inline void writeDispatchedOrderJSON(JsonWriter& w, const Order& o) {
+    w.raw("{\"id\": ").integer(o.id)
+     .raw(", \"text\": \"Item: ").escaped(o.itemName).raw(" (Sent)\"}");
+}
+
+inline void writeItemJSON(JsonWriter& w, const Item& item) {
+    w.raw("{\"id\": ").integer(item.id)
+     .raw(", \"name\": ").quoted(item.name)
+     .raw(", \"qty\": ").integer(item.quantity)
+     .raw(", \"loc\": ").integer(item.locationNode);
+    // Only items slotted in more than one bin carry the breakdown
+    if (item.bins.size() > 1) {
+        w.raw(", \"bins\": [");
+        for (size_t i = 0; i < item.bins.size(); ++i) {
+            w.raw(i ? ", {\"node\": " : "{\"node\": ").integer(item.bins[i].node)
+             .raw(", \"qty\": ").integer(item.bins[i].quantity).raw('}');
+        }
+        w.raw(']');
+    }
+    w.raw('}');
+}
+
+inline void writeProductJSON(JsonWriter& w, const BSTNode& p) {
+    w.raw("{\"id\": ").integer(p.productId)
+     .raw(", \"name\": ").quoted(p.productName)
+     .raw(", \"cat\": ").quoted(*p.category)
+     .raw(", \"price\": ").number(p.price).raw('}');
+}
+
+inline void writePendingJSON(JsonWriter& w, const vector<Order>& pending) {
+    w.raw("\"pending\": [");
+    for (size_t i = 0; i < pending.size(); ++i) {
+        if (i) w.raw(',');
+        writePendingOrderJSON(w, pending[i]);
+    }
+    w.raw(']');
+}
+
+// Reused per thread by the handlers that build a response in pieces
+inline JsonWriter& responseWriter() {
+    thread_local JsonWriter w;
+    w.clear();
+    return w;
+}
+
+// Finish a response: one write, then the line end the API protocol expects
+inline void sendResponse(JsonWriter& w) {
+    w.flushTo(apiOut());
+    apiOut() << endl;
+}
+
+#endif
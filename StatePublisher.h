@@ -0,0 +1,325 @@
+#ifndef STATEPUBLISHER_H
+#define STATEPUBLISHER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <algorithm>
+#include <unordered_set>
+#include "PersistentMap.h"
+#include "JsonWriter.h"
+#include "StateJSON.h"
+#include "ChangeJournal.h"
+#include "InventoryManager.h"
+#include "ProductCatalog.h"
+#include "OrderManager.h"
+
+using namespace std;
+
+// One entity's rendered JSON, shared by every view that still contains it
+typedef shared_ptr<const string> JsonFragment;
+
+// A pending order's place in the heap's order: higher priority first, then
+// lower ID (the same order forEachTopK walks)
+struct PendingRank {
+    int priority;
+    int id;
+};
+
+struct PendingRankBefore {
+    bool operator()(const PendingRank& a, const PendingRank& b) const {
+        if (a.priority != b.priority) return a.priority > b.priority;
+        return a.id < b.id;
+    }
+};
+
+// Immutable, point-in-time copy of what GET_STATE shows, as of journal
+// 'version'. Copying one is a handful of pointer copies.
+struct StateView {
+    long long version = 0;
+    long long epoch = 0;                              // The journal's, see ChangeJournal
+    PersistentMap<PendingRank, JsonFragment, PendingRankBefore> pending;
+    PersistentMap<int, int> pendingPriority;          // Order ID -> priority, to find its rank
+    PersistentMap<long long, JsonFragment> dispatched; // Queue position -> order
+    PersistentMap<int, long long> dispatchedPosition;  // Order ID -> queue position
+    PersistentMap<int, JsonFragment> inventory;        // By item ID
+    PersistentMap<int, JsonFragment> catalog;          // By product ID
+};
+
+// Copy-on-write read snapshots for HTTP mode. After each mutating command the
+// writer calls publish(): the entities the journal lists as changed are
+// re-rendered into a new StateView that shares everything else with the
+// previous one, and the view is swapped in atomically. Readers take the
+// current view with view() and build GET_STATE / GET_STATE_SINCE / GET_PENDING
+// from it without any engine lock, so a dashboard poll never holds up order
+// intake and always sees one consistent version. A view (and the nodes only it
+// uses) is freed when its last reader lets go.
+//
+// Differences from StateSerializer: inventory is listed in item ID order
+// rather than hash table order.
+class StatePublisher {
+private:
+    ChangeJournal& journal;
+    shared_ptr<const StateView> current; // Only through atomic_load / atomic_store
+
+    // Writer side
+    StateView next;
+    long long publishedVersion = -1;
+    deque<int> dispatchedIds;   // Order IDs in the published queue, front first
+    long long dispatchedFront = 0;
+    vector<pair<int, int>> touched; // (kind, id) changed since the last publish
+    JsonWriter scratch;
+
+    template <typename Entity, typename Render>
+    JsonFragment render(const Entity& e, Render renderJSON) {
+        scratch.clear();
+        renderJSON(scratch, e);
+        return make_shared<const string>(scratch.str());
+    }
+
+    void rebuild(InventoryManager& inv, const ProductCatalog& cat, const OrderManager& om) {
+        vector<pair<PendingRank, JsonFragment>> pending;
+        vector<pair<int, int>> priorities;
+        om.forEachTopK(om.pendingCount(), [&](const Order& o) {
+            pending.push_back({{o.priority, o.id}, render(o, writePendingOrderJSON)});
+            priorities.push_back({o.id, o.priority});
+        });
+        sort(priorities.begin(), priorities.end());
+        next.pending.assignSorted(pending);
+        next.pendingPriority.assignSorted(priorities);
+
+        vector<pair<long long, JsonFragment>> dispatched;
+        vector<pair<int, long long>> positions;
+        dispatchedIds.clear();
+        dispatchedFront = 0;
+        for (const Order& o : om.dispatchedOrders()) {
+            long long position = (long long)dispatched.size();
+            dispatched.push_back({position, render(o, writeDispatchedOrderJSON)});
+            positions.push_back({o.id, position});
+            dispatchedIds.push_back(o.id);
+        }
+        sort(positions.begin(), positions.end());
+        next.dispatched.assignSorted(dispatched);
+        next.dispatchedPosition.assignSorted(positions);
+
+        vector<pair<int, JsonFragment>> items;
+        inv.forEachItem([&](const Item& item) { items.push_back({item.id, render(item, writeItemJSON)}); });
+        sort(items.begin(), items.end(),
+             [](const pair<int, JsonFragment>& a, const pair<int, JsonFragment>& b) { return a.first < b.first; });
+        next.inventory.assignSorted(items);
+
+        vector<pair<int, JsonFragment>> products;
+        cat.forEachProduct([&](const BSTNode& p) { products.push_back({p.productId, render(p, writeProductJSON)}); });
+        next.catalog.assignSorted(products);
+    }
+
+    void updatePending(const OrderManager& om, int id) {
+        if (const int* priority = next.pendingPriority.find(id)) {
+            next.pending.erase({*priority, id});
+            next.pendingPriority.erase(id);
+        }
+        if (const Order* o = om.findPendingOrder(id)) {
+            next.pending.insert({o->priority, o->id}, render(*o, writePendingOrderJSON));
+            next.pendingPriority.insert(o->id, o->priority);
+        }
+    }
+
+    void popDispatchedFront() {
+        next.dispatched.erase(dispatchedFront);
+        next.dispatchedPosition.erase(dispatchedIds.front());
+        dispatchedIds.pop_front();
+        ++dispatchedFront;
+    }
+
+    void popDispatchedBack() {
+        next.dispatched.erase(dispatchedFront + (long long)dispatchedIds.size() - 1);
+        next.dispatchedPosition.erase(dispatchedIds.back());
+        dispatchedIds.pop_back();
+    }
+
+    // Bring the published queue in line with the live one. Orders only leave
+    // the front (dispatch) or the back (undo of a process) and only join at the
+    // back, and each such step is one journal entry: at most 'changes' entries
+    // at either end differ, so this never scans the whole queue.
+    void syncDispatched(const OrderManager& om, size_t changes) {
+        const deque<Order>& live = om.dispatchedOrders();
+        while (!dispatchedIds.empty() && (live.empty() || dispatchedIds.front() != live.front().id)) {
+            popDispatchedFront();
+        }
+        size_t common = dispatchedIds.size() > changes ? dispatchedIds.size() - changes : 0;
+        while (common < dispatchedIds.size() && common < live.size() && dispatchedIds[common] == live[common].id) {
+            ++common;
+        }
+        while (dispatchedIds.size() > common) popDispatchedBack();
+        for (size_t i = common; i < live.size(); ++i) {
+            long long position = dispatchedFront + (long long)dispatchedIds.size();
+            next.dispatched.insert(position, render(live[i], writeDispatchedOrderJSON));
+            next.dispatchedPosition.insert(live[i].id, position);
+            dispatchedIds.push_back(live[i].id);
+        }
+    }
+
+    static void writeFragments(JsonWriter& w, const char* name, const PersistentMap<int, JsonFragment>& fragments) {
+        w.raw(name);
+        bool first = true;
+        fragments.forEach([&](int, const JsonFragment& f) {
+            if (!first) w.raw(',');
+            first = false;
+            w.raw(*f);
+        });
+        w.raw(']');
+    }
+
+    // Same layout as StateSerializer's deltas
+    template <typename Lookup>
+    static void writeDeltaSection(JsonWriter& w, const char* name, const vector<int>& ids, Lookup lookup) {
+        vector<int> removed;
+        w.raw('"').raw(name).raw("\": {\"upsert\": [");
+        bool first = true;
+        for (int id : ids) {
+            const JsonFragment* f = lookup(id);
+            if (!f) {
+                removed.push_back(id);
+                continue;
+            }
+            if (!first) w.raw(',');
+            first = false;
+            w.raw(**f);
+        }
+        w.raw("], \"removed\": [");
+        for (size_t i = 0; i < removed.size(); ++i) {
+            if (i) w.raw(',');
+            w.integer(removed[i]);
+        }
+        w.raw("]}");
+    }
+
+public:
+    explicit StatePublisher(ChangeJournal& j) : journal(j), current(make_shared<const StateView>()) {}
+
+    StatePublisher(const StatePublisher&) = delete;
+    StatePublisher& operator=(const StatePublisher&) = delete;
+
+    // Writer only (with the engine exclusively held): publish the current
+    // state if anything changed since the last call
+    void publish(InventoryManager& inv, ProductCatalog& cat, const OrderManager& om) {
+        vector<ChangeEntry> changes;
+        if (publishedVersion < 0 || !journal.changesSince(publishedVersion, changes)) {
+            rebuild(inv, cat, om);
+            next.version = journal.currentVersion();
+        } else if (changes.empty()) {
+            return;
+        } else {
+            // Each changed entity once; the order doesn't matter here
+            size_t dispatchChanges = 0;
+            touched.clear();
+            for (const ChangeEntry& c : changes) {
+                if (c.kind == DISPATCHED_ORDER) ++dispatchChanges;
+                else touched.push_back({c.kind, c.id});
+            }
+            sort(touched.begin(), touched.end());
+            touched.erase(unique(touched.begin(), touched.end()), touched.end());
+            for (const pair<int, int>& t : touched) {
+                int id = t.second;
+                if (t.first == PENDING_ORDER) {
+                    updatePending(om, id);
+                } else if (t.first == INVENTORY_ITEM) {
+                    Item item;
+                    if (inv.getItemCopy(id, item)) next.inventory.insert(id, render(item, writeItemJSON));
+                    else next.inventory.erase(id);
+                } else {
+                    BSTNode* p = cat.findProduct(id);
+                    if (p) next.catalog.insert(id, render(*p, writeProductJSON));
+                    else next.catalog.erase(id);
+                }
+            }
+            if (dispatchChanges > 0) syncDispatched(om, dispatchChanges);
+            next.version = changes.back().version;
+        }
+        next.epoch = journal.currentEpoch();
+        publishedVersion = next.version;
+        atomic_store(&current, shared_ptr<const StateView>(make_shared<StateView>(next)));
+    }
+
+    // Any thread: the latest published view, kept alive while the caller holds it
+    shared_ptr<const StateView> view() const { return atomic_load(&current); }
+
+    // Full state from a view; the same JSON as StateSerializer::writeState
+    static void writeState(JsonWriter& w, const StateView& v, size_t pendingLimit = (size_t)-1) {
+        w.raw("{\"status\": \"success\",\"full\": true, \"version\": ").integer(v.version)
+         .raw(", \"epoch\": ").integer(v.epoch).raw(",\"pending\": [");
+        bool first = true;
+        v.pending.forEach([&](const PendingRank&, const JsonFragment& f) {
+            if (!first) w.raw(',');
+            first = false;
+            w.raw(*f);
+        }, 0, pendingLimit);
+        w.raw("],\"pendingTotal\": ").integer((long long)v.pending.size()).raw(',');
+        first = true;
+        w.raw("\"dispatched\": [");
+        v.dispatched.forEach([&](long long, const JsonFragment& f) {
+            if (!first) w.raw(',');
+            first = false;
+            w.raw(*f);
+        });
+        w.raw(']');
+        writeFragments(w, ",\"inventory\": [", v.inventory);
+        writeFragments(w, ",\"catalog\": [", v.catalog);
+        w.raw('}');
+    }
+
+    // GET_STATE_SINCE against a view: entities changed after 'since' up to the
+    // view's version. Full state when the journal no longer reaches back that
+    // far, 'since' is newer than the view, or it is from another run (epoch).
+    static void writeDelta(JsonWriter& w, const StateView& v, const ChangeJournal& changeLog, long long since,
+                           long long epoch) {
+        vector<ChangeEntry> changes;
+        if (epoch != v.epoch || since > v.version || !changeLog.changesSince(since, changes)) {
+            writeState(w, v);
+            return;
+        }
+
+        // Distinct IDs per kind, ignoring changes newer than the view
+        vector<int> ids[4];
+        unordered_set<long long> seen;
+        for (const ChangeEntry& c : changes) {
+            if (c.version > v.version) break;
+            long long key = ((long long)c.kind << 32) | (unsigned int)c.id;
+            if (seen.insert(key).second) ids[c.kind].push_back(c.id);
+        }
+
+        w.raw("{\"status\": \"success\", \"full\": false, \"version\": ").integer(v.version)
+         .raw(", \"epoch\": ").integer(v.epoch)
+         .raw(", \"pendingTotal\": ").integer((long long)v.pending.size()).raw(',');
+        writeDeltaSection(w, "pending", ids[PENDING_ORDER], [&v](int id) -> const JsonFragment* {
+            const int* priority = v.pendingPriority.find(id);
+            return priority ? v.pending.find({*priority, id}) : nullptr;
+        });
+        w.raw(',');
+        writeDeltaSection(w, "dispatched", ids[DISPATCHED_ORDER], [&v](int id) -> const JsonFragment* {
+            const long long* position = v.dispatchedPosition.find(id);
+            return position ? v.dispatched.find(*position) : nullptr;
+        });
+        w.raw(',');
+        writeDeltaSection(w, "inventory", ids[INVENTORY_ITEM], [&v](int id) { return v.inventory.find(id); });
+        w.raw(',');
+        writeDeltaSection(w, "catalog", ids[CATALOG_PRODUCT], [&v](int id) { return v.catalog.find(id); });
+        w.raw('}');
+    }
+
+    // GET_PENDING from a view, by rank
+    static void writePending(JsonWriter& w, const StateView& v, size_t offset, size_t limit) {
+        w.raw("{\"status\": \"success\", \"total\": ").integer((long long)v.pending.size())
+         .raw(", \"offset\": ").integer((long long)offset).raw(",\"pending\": [");
+        bool first = true;
+        v.pending.forEach([&](const PendingRank&, const JsonFragment& f) {
+            if (!first) w.raw(',');
+            first = false;
+            w.raw(*f);
+        }, offset, limit);
+        w.raw("]}");
+    }
+};
+
+#endif
@@ -0,0 +1,326 @@
+#ifndef STATESERIALIZER_H
+#define STATESERIALIZER_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <limits>
+#include <unordered_set>
+#include "JsonWriter.h"
+#include "FlatHashMap.h"
+#include "StateJSON.h"
+#include "ChangeJournal.h"
+#include "InventoryManager.h"
+#include "ProductCatalog.h"
+#include "OrderManager.h"
+
+using namespace std;
+
+// Builds GET_STATE / GET_STATE_SINCE responses straight from the live
+// structures into one reused buffer, written out in a single call.
+//
+// Inventory and catalog entries are cached as serialized fragments, and each
+// whole section is cached as well. The change journal says which items and
+// products were touched since the last request; only those fragments are
+// re-rendered, and an untouched section is copied as is. If the journal no
+// longer reaches back far enough, everything is rebuilt. Pending and
+// dispatched orders change on nearly every request and are written fresh.
+class StateSerializer {
+private:
+    // One entity's cached JSON and where it sits in its section
+    struct Fragment {
+        string text;
+        size_t offset = 0;
+        bool stale = false;   // Entity changed since 'text' was rendered
+    };
+
+    ChangeJournal* journal;   // Null: no caching, everything rendered each time
+    mutex cacheLock;          // HTTP mode serializes on several threads at once
+
+    long long syncedVersion = -1; // Journal version the caches reflect (-1 = empty)
+    FlatHashMap<Fragment> itemFragments;
+    FlatHashMap<Fragment> productFragments;
+    vector<int> dirtyItems;       // Changed since the section was last brought up to date
+    vector<int> dirtyProducts;
+    string inventorySection;  // Comma-joined fragments, in table order
+    string catalogSection;    // In ID order
+    bool inventoryValid = false;
+    bool catalogValid = false;
+    JsonWriter scratch;       // Renders one fragment
+
+    void dropAll() {
+        itemFragments = FlatHashMap<Fragment>();
+        productFragments = FlatHashMap<Fragment>();
+        dirtyItems.clear();
+        dirtyProducts.clear();
+        inventoryValid = catalogValid = false;
+    }
+
+    static void markStale(FlatHashMap<Fragment>& fragments, vector<int>& dirty, int id) {
+        if (Fragment* f = fragments.find(id)) f->stale = true;
+        dirty.push_back(id);
+    }
+
+    // Mark whatever the journal says changed since the last sync
+    void sync() {
+        long long now = journal->currentVersion();
+        vector<ChangeEntry> changes;
+        if (syncedVersion < 0 || !journal->changesSince(syncedVersion, changes)) {
+            dropAll();
+            syncedVersion = now;
+            return;
+        }
+        for (const ChangeEntry& c : changes) {
+            if (c.kind == INVENTORY_ITEM) markStale(itemFragments, dirtyItems, c.id);
+            else if (c.kind == CATALOG_PRODUCT) markStale(productFragments, dirtyProducts, c.id);
+        }
+        if (!changes.empty()) syncedVersion = changes.back().version;
+    }
+
+    // Re-render the dirty entries in place. Only works while every one of them
+    // is already in the section with a same-length rendering (a stock count
+    // that keeps its digit count); returns false if the section must be rebuilt.
+    template <typename Lookup>
+    bool patchSection(string& section, FlatHashMap<Fragment>& fragments, vector<int>& dirty, Lookup lookup) {
+        for (int id : dirty) {
+            Fragment* f = fragments.find(id);
+            if (!f) return false;
+            if (!f->stale) continue; // Listed twice
+            scratch.clear();
+            if (!lookup(id, scratch)) return false;
+            if (scratch.size() != f->text.size()) return false;
+            f->text = scratch.str();
+            f->stale = false;
+            section.replace(f->offset, f->text.size(), f->text);
+        }
+        dirty.clear();
+        return true;
+    }
+
+    // Append an entity's fragment to its section, rendering it if needed
+    template <typename Entity, typename Render>
+    void appendFragment(string& section, FlatHashMap<Fragment>& fragments, int id, const Entity& e, Render render) {
+        Fragment* f = fragments.find(id);
+        if (!f || f->stale || f->text.empty()) {
+            scratch.clear();
+            render(scratch, e);
+            Fragment fresh;
+            fresh.text = scratch.str();
+            f = fragments.insert(id, std::move(fresh));
+        }
+        if (!section.empty()) section += ',';
+        f->offset = section.size();
+        section += f->text;
+    }
+
+    void refreshSections(InventoryManager& inv, const ProductCatalog& cat) {
+        if (inventoryValid && !dirtyItems.empty()) {
+            inventoryValid = patchSection(inventorySection, itemFragments, dirtyItems, [&inv](int id, JsonWriter& w) {
+                Item item;
+                if (!inv.getItemCopy(id, item)) return false;
+                writeItemJSON(w, item);
+                return true;
+            });
+        }
+        if (!inventoryValid) {
+            inventorySection.clear();
+            inv.forEachItem([this](const Item& item) {
+                appendFragment(inventorySection, itemFragments, item.id, item, writeItemJSON);
+            });
+            dirtyItems.clear();
+            inventoryValid = true;
+        }
+
+        // Products never change once added: any catalog entry means a new product
+        if (!dirtyProducts.empty()) catalogValid = false;
+        if (!catalogValid) {
+            catalogSection.clear();
+            cat.forEachProduct([this](const BSTNode& p) {
+                appendFragment(catalogSection, productFragments, p.productId, p, writeProductJSON);
+            });
+            dirtyProducts.clear();
+            catalogValid = true;
+        }
+    }
+
+    // Cached fragment if it is current, else rendered straight into 'w' (the
+    // section patching owns cache updates)
+    void writeItem(JsonWriter& w, const Item& item) {
+        const Fragment* f = itemFragments.find(item.id);
+        if (f && !f->stale && !f->text.empty()) w.raw(f->text);
+        else writeItemJSON(w, item);
+    }
+
+    void writeProduct(JsonWriter& w, const BSTNode& p) {
+        const Fragment* f = productFragments.find(p.productId);
+        if (f && !f->stale && !f->text.empty()) w.raw(f->text);
+        else writeProductJSON(w, p);
+    }
+
+    // Writes {"upsert": [...], "removed": [...]} for one entity kind.
+    // 'lookup(id)' writes the entity and returns true if it still exists.
+    template <typename Lookup>
+    static void writeDeltaSection(JsonWriter& w, const char* name, const vector<int>& ids, Lookup lookup) {
+        vector<int> removed;
+        w.raw('"').raw(name).raw("\": {\"upsert\": [");
+        bool first = true;
+        for (int id : ids) {
+            size_t mark = w.size();
+            if (!first) w.raw(',');
+            if (lookup(id)) {
+                first = false;
+            } else {
+                w.truncate(mark); // Gone: take back the separator
+                removed.push_back(id);
+            }
+        }
+        w.raw("], \"removed\": [");
+        for (size_t i = 0; i < removed.size(); ++i) {
+            if (i) w.raw(',');
+            w.integer(removed[i]);
+        }
+        w.raw("]}");
+    }
+
+public:
+    explicit StateSerializer(ChangeJournal* j = nullptr) : journal(j) {}
+
+    StateSerializer(const StateSerializer&) = delete;
+    StateSerializer& operator=(const StateSerializer&) = delete;
+
+    // Full state. pendingLimit caps how many pending orders are serialized
+    // (the dashboard only shows the first rows); pendingTotal always carries
+    // the full count.
+    void writeState(JsonWriter& w, InventoryManager& inv, const ProductCatalog& cat, const OrderManager& om,
+                    long long version, size_t pendingLimit = numeric_limits<size_t>::max()) {
+        w.raw("{\"status\": \"success\",\"full\": true, \"version\": ").integer(version);
+        if (journal) w.raw(", \"epoch\": ").integer(journal->currentEpoch());
+        w.raw(",\"pending\": [");
+        bool first = true;
+        om.forEachTopK(pendingLimit, [&](const Order& o) {
+            if (!first) w.raw(',');
+            first = false;
+            writePendingOrderJSON(w, o);
+        });
+        w.raw("],\"pendingTotal\": ").integer((long long)om.pendingCount()).raw(",\"dispatched\": [");
+        first = true;
+        for (const Order& o : om.dispatchedOrders()) {
+            if (!first) w.raw(',');
+            first = false;
+            writeDispatchedOrderJSON(w, o);
+        }
+
+        if (!journal) {
+            // Nothing says what changed: render every entry
+            w.raw("],\"inventory\": [");
+            first = true;
+            inv.forEachItem([&](const Item& item) {
+                if (!first) w.raw(',');
+                first = false;
+                writeItemJSON(w, item);
+            });
+            w.raw("],\"catalog\": [");
+            first = true;
+            cat.forEachProduct([&](const BSTNode& p) {
+                if (!first) w.raw(',');
+                first = false;
+                writeProductJSON(w, p);
+            });
+            w.raw("]}");
+            return;
+        }
+
+        lock_guard<mutex> lk(cacheLock);
+        sync();
+        refreshSections(inv, cat);
+        w.raw("],\"inventory\": [").raw(inventorySection).raw("],\"catalog\": [").raw(catalogSection).raw("]}");
+    }
+
+    // GET_STATE_SINCE: only the entities touched after 'since'. Falls back to
+    // a full snapshot ("full": true) when the journal was truncated or 'since'
+    // is from another run (epoch mismatch).
+    void writeDelta(JsonWriter& w, InventoryManager& inv, ProductCatalog& cat, const OrderManager& om,
+                    const ChangeJournal& changeLog, long long since, long long epoch) {
+        vector<ChangeEntry> changes;
+        if (epoch != changeLog.currentEpoch() || !changeLog.changesSince(since, changes)) {
+            writeState(w, inv, cat, om, changeLog.currentVersion());
+            return;
+        }
+
+        // Distinct IDs per kind; the current state is read from the live structures
+        vector<int> ids[4];
+        unordered_set<long long> seen;
+        for (const ChangeEntry& c : changes) {
+            long long key = ((long long)c.kind << 32) | (unsigned int)c.id;
+            if (seen.insert(key).second) ids[c.kind].push_back(c.id);
+        }
+
+        w.raw("{\"status\": \"success\", \"full\": false, \"version\": ").integer(changeLog.currentVersion())
+         .raw(", \"epoch\": ").integer(epoch)
+         .raw(", \"pendingTotal\": ").integer((long long)om.pendingCount()).raw(',');
+
+        writeDeltaSection(w, "pending", ids[PENDING_ORDER], [&](int id) {
+            const Order* o = om.findPendingOrder(id);
+            if (o) writePendingOrderJSON(w, *o);
+            return o != nullptr;
+        });
+        w.raw(',');
+
+        // Dispatch queue has no index: one scan for all changed IDs
+        unordered_set<int> wanted(ids[DISPATCHED_ORDER].begin(), ids[DISPATCHED_ORDER].end());
+        vector<const Order*> dispatchedChanged;
+        if (!wanted.empty()) {
+            for (const Order& o : om.dispatchedOrders()) {
+                if (wanted.count(o.id)) dispatchedChanged.push_back(&o);
+            }
+        }
+        writeDeltaSection(w, "dispatched", ids[DISPATCHED_ORDER], [&](int id) {
+            for (const Order* o : dispatchedChanged) {
+                if (o->id == id) {
+                    writeDispatchedOrderJSON(w, *o);
+                    return true;
+                }
+            }
+            return false;
+        });
+        w.raw(',');
+
+        unique_lock<mutex> lk(cacheLock, defer_lock);
+        if (journal) {
+            lk.lock();
+            sync();
+        }
+        writeDeltaSection(w, "inventory", ids[INVENTORY_ITEM], [&](int id) {
+            Item* item = inv.getItem(id);
+            if (item) writeItem(w, *item);
+            return item != nullptr;
+        });
+        w.raw(',');
+        writeDeltaSection(w, "catalog", ids[CATALOG_PRODUCT], [&](int id) {
+            BSTNode* p = cat.findProduct(id);
+            if (p) writeProduct(w, *p);
+            return p != nullptr;
+        });
+        w.raw('}');
+    }
+
+    // Convenience wrappers: build the response and send it to apiOut()
+    void printState(InventoryManager& inv, const ProductCatalog& cat, const OrderManager& om, long long version,
+                    size_t pendingLimit = numeric_limits<size_t>::max()) {
+        JsonWriter& w = responseWriter();
+        writeState(w, inv, cat, om, version, pendingLimit);
+        sendResponse(w);
+    }
+
+    void printDelta(InventoryManager& inv, ProductCatalog& cat, const OrderManager& om, const ChangeJournal& changeLog,
+                    long long since, long long epoch) {
+        JsonWriter& w = responseWriter();
+        writeDelta(w, inv, cat, om, changeLog, since, epoch);
+        sendResponse(w);
+    }
+
+    size_t cachedFragments() const { return itemFragments.size() + productFragments.size(); }
+    size_t cachedBytes() const { return inventorySection.capacity() + catalogSection.capacity(); }
+};
+
+#endif
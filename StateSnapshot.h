@@ -0,0 +1,169 @@
+#ifndef STATESNAPSHOT_H
+#define STATESNAPSHOT_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include "BinaryIO.h"
+#include "MappedFile.h"
+#include "InventoryManager.h"
+#include "ProductCatalog.h"
+#include "OrderManager.h"
+#include "ActionHistory.h"
+
+using namespace std;
+
+// Compact binary snapshot of the mutable warehouse state.
+// Layout: magic, LSN of the last WAL record it covers, order counter,
+// then inventory, catalog, pending orders, dispatch queue and undo history,
+// each as a count followed by fixed-width fields and length-prefixed strings.
+// Version 02 added item bins and order picks.
+static const char SNAPSHOT_MAGIC[8] = {'W', 'H', 'S', 'N', 'A', 'P', '0', '2'};
+
+inline void putBins(BinaryWriter& w, const vector<BinQuantity>& bins) {
+    w.put<uint32_t>((uint32_t)bins.size());
+    for (const BinQuantity& b : bins) {
+        w.put<int32_t>(b.node);
+        w.put<int32_t>(b.quantity);
+    }
+}
+
+inline vector<BinQuantity> getBins(BinaryReader& r) {
+    vector<BinQuantity> bins;
+    uint32_t count = r.get<uint32_t>();
+    for (uint32_t i = 0; i < count && r.ok; ++i) {
+        int node = r.get<int32_t>();
+        int qty = r.get<int32_t>();
+        bins.push_back({node, qty});
+    }
+    return bins;
+}
+
+inline void putOrder(BinaryWriter& w, const Order& o) {
+    w.put<int32_t>(o.id);
+    w.put<int32_t>(o.priority);
+    w.put<int32_t>(o.itemId);
+    w.put<int32_t>(o.quantity);
+    w.put<int32_t>(o.itemLocationNode);
+    w.putString(o.itemName);
+    putBins(w, o.picks);
+}
+
+inline Order getOrder(BinaryReader& r) {
+    Order o;
+    o.id = r.get<int32_t>();
+    o.priority = r.get<int32_t>();
+    o.itemId = r.get<int32_t>();
+    o.quantity = r.get<int32_t>();
+    o.itemLocationNode = r.get<int32_t>();
+    o.itemName = r.getString();
+    o.picks = getBins(r);
+    return o;
+}
+
+inline bool saveSnapshot(const string& path, uint64_t lsn, int orderCounter,
+                         InventoryManager& inv, ProductCatalog& cat, OrderManager& om, ActionHistory& hist) {
+    BinaryWriter w;
+    w.putBytes(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    w.put<uint64_t>(lsn);
+    w.put<int32_t>(orderCounter);
+
+    vector<Item> items = inv.getInventory();
+    w.put<uint32_t>((uint32_t)items.size());
+    for (const Item& item : items) {
+        w.put<int32_t>(item.id);
+        w.put<int32_t>(item.quantity);
+        w.put<int32_t>(item.locationNode);
+        w.putString(item.name);
+        putBins(w, item.bins);
+    }
+
+    vector<const BSTNode*> products = cat.getCatalog();
+    w.put<uint32_t>((uint32_t)products.size());
+    for (const BSTNode* p : products) {
+        w.put<int32_t>(p->productId);
+        w.put<double>(p->price);
+        w.putString(p->productName);
+        w.putString(*p->category);
+    }
+
+    const vector<Order>& pending = om.pendingHeapOrder();
+    w.put<uint32_t>((uint32_t)pending.size());
+    for (const Order& o : pending) putOrder(w, o);
+
+    vector<Order> dispatched = om.getDispatchedOrders();
+    w.put<uint32_t>((uint32_t)dispatched.size());
+    for (const Order& o : dispatched) putOrder(w, o);
+
+    vector<ActionRecord> records = hist.getRecords();
+    w.put<uint32_t>((uint32_t)records.size());
+    for (const ActionRecord& r : records) {
+        w.put<int32_t>(r.type);
+        w.put<int32_t>(r.orderId);
+        w.put<int32_t>(r.itemId);
+        w.put<int32_t>(r.quantity);
+        w.put<int32_t>(r.priority);
+    }
+
+    return writeFileAtomic(path, w.buffer);
+}
+
+// Load a snapshot into empty managers (memory-mapped read).
+// Returns false if the file is missing or damaged; the managers may then be
+// partially filled and should not be used.
+inline bool loadSnapshot(const string& path, uint64_t& lsn, int& orderCounter,
+                         InventoryManager& inv, ProductCatalog& cat, OrderManager& om, ActionHistory& hist) {
+    MappedFile mf;
+    if (!mf.open(path) || mf.size() < sizeof(SNAPSHOT_MAGIC)) return false;
+    if (memcmp(mf.data(), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) return false;
+
+    BinaryReader r(mf.data() + sizeof(SNAPSHOT_MAGIC), mf.size() - sizeof(SNAPSHOT_MAGIC));
+    lsn = r.get<uint64_t>();
+    orderCounter = r.get<int32_t>();
+
+    uint32_t count = r.get<uint32_t>();
+    vector<Item> items;
+    items.reserve(count);
+    for (uint32_t i = 0; i < count && r.ok; ++i) {
+        Item item;
+        item.id = r.get<int32_t>();
+        item.quantity = r.get<int32_t>();
+        item.locationNode = r.get<int32_t>();
+        item.name = r.getString();
+        item.bins = getBins(r);
+        items.push_back(item);
+    }
+    inv.addItems(items);
+
+    count = r.get<uint32_t>();
+    for (uint32_t i = 0; i < count && r.ok; ++i) {
+        int id = r.get<int32_t>();
+        double price = r.get<double>();
+        string name = r.getString();
+        string category = r.getString();
+        cat.addProduct(id, name, category, price);
+    }
+
+    // Heap order: each push lands in place without sifting
+    count = r.get<uint32_t>();
+    for (uint32_t i = 0; i < count && r.ok; ++i) om.restoreOrder(getOrder(r));
+
+    count = r.get<uint32_t>();
+    for (uint32_t i = 0; i < count && r.ok; ++i) om.acceptRouted(getOrder(r));
+
+    count = r.get<uint32_t>();
+    for (uint32_t i = 0; i < count && r.ok; ++i) {
+        ActionRecord rec;
+        rec.type = (ActionType)r.get<int32_t>();
+        rec.orderId = r.get<int32_t>();
+        rec.itemId = r.get<int32_t>();
+        rec.quantity = r.get<int32_t>();
+        rec.priority = r.get<int32_t>();
+        hist.logAction(rec);
+    }
+
+    return r.ok;
+}
+
+#endif
@@ -9,86 +9,819 @@
 #include <algorithm>
 #include <utility>
 #include <iostream>
+#include "LatencyStats.h"
+#include "ContractionHierarchy.h"
 
 using namespace std;
 
+// One undirected connection, as read from a layout file
+struct GraphEdge {
+    int u, v, weight;
+};
+
+// Shortest-path tree rooted at one source node.
+// Only reachable nodes have entries; the source has no parent.
+struct ShortestPathTree {
+    unordered_map<int, int> dist;
+    unordered_map<int, int> parent;
+};
+
+// Shortest-path tree over dense node indices (compiled mode).
+// dist[i] == -1 means unreachable; parent of the source is -1.
+struct FlatPathTree {
+    vector<int> dist;
+    vector<int> parent;
+};
+
 // Represents the warehouse layout as a weighted graph
 class WarehouseGraph {
 private:
     // Adjacency list: Node -> list of {neighbor, weight}
     unordered_map<int, vector<pair<int, int>>> adj;
 
+    // Cached shortest-path trees, keyed by source node.
+    // Most queries start at the depot (node 0), so the tree is built once and reused.
+    unordered_map<int, ShortestPathTree> treeCache;
+    list<int> treeCacheOrder; // Insertion order, oldest first (for eviction)
+    size_t treeCacheLimit = 16;
+
+    // --- Compiled (frozen) mode ---
+    // Node IDs are remapped to 0..N-1 and edges stored in compressed-sparse-row
+    // form: the neighbours of dense node i are csrTarget[csrStart[i] .. csrStart[i+1]).
+    bool compiled = false;
+    vector<int> denseToNode;            // Dense index -> original node ID
+    unordered_map<int, int> nodeToDense; // Original node ID -> dense index
+    vector<int> csrStart;
+    vector<int> csrTarget;
+    vector<int> csrWeight;
+    int maxWeight = 0;
+
+    // ALT landmarks (compiled mode only): landmarkDist[v * landmarks.size() + i] is
+    // the distance between dense node v and landmark i, -1 if unreachable.
+    // Node-major, so one node's bounds sit together in one or two cache lines.
+    vector<int> landmarks;    // Dense indices
+    vector<int> landmarkDist;
+
+    // Optional contraction-hierarchy index for the compiled layout (not owned)
+    const ContractionHierarchy* hierarchy = nullptr;
+
+    unordered_map<int, FlatPathTree> flatTreeCache; // Keyed by dense source index
+    list<int> flatTreeCacheOrder;
+    vector<vector<int>> buckets; // Scratch space for the bucket queue, reused across builds
+
+    // Above this the bucket array gets too sparse; fall back to a binary heap
+    static const int MAX_BUCKET_WEIGHT = 1 << 16;
+
+    LatencyStats* stats = nullptr; // Optional: times searches into the Dijkstra span
+
+    typedef priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> MinQueue;
+
+    // Relax outgoing edges until the queue drains. Only ever lowers distances,
+    // so it serves both a full build and a repair after an edge insertion.
+    void relaxFrom(ShortestPathTree& tree, MinQueue& pq) {
+        while (!pq.empty()) {
+            int d = pq.top().first;
+            int u = pq.top().second;
+            pq.pop();
+
+            // If we found a shorter path before, skip this stale entry
+            if (d > tree.dist[u]) continue;
+
+            auto it = adj.find(u);
+            if (it == adj.end()) continue;
+
+            for (auto& edge : it->second) {
+                int v = edge.first;
+                int nd = d + edge.second;
+                auto dv = tree.dist.find(v);
+                if (dv == tree.dist.end() || nd < dv->second) {
+                    tree.dist[v] = nd;
+                    tree.parent[v] = u;
+                    pq.push({nd, v});
+                }
+            }
+        }
+    }
+
+    // Full Dijkstra from source (no early exit, the whole tree is kept)
+    ShortestPathTree& buildTree(int source) {
+        SpanTimer timer(stats, SPAN_DIJKSTRA);
+        if (treeCache.size() >= treeCacheLimit && !treeCacheOrder.empty()) {
+            treeCache.erase(treeCacheOrder.front());
+            treeCacheOrder.pop_front();
+        }
+
+        ShortestPathTree& tree = treeCache[source];
+        treeCacheOrder.push_back(source);
+
+        tree.dist.reserve(adj.size());
+        tree.parent.reserve(adj.size());
+        tree.dist[source] = 0;
+
+        MinQueue pq;
+        pq.push({0, source});
+        relaxFrom(tree, pq);
+        return tree;
+    }
+
+    // A new edge can only shorten paths. Seed the endpoints that improve
+    // and let relaxFrom propagate the decrease through the cached tree.
+    void repairTree(ShortestPathTree& tree, int u, int v, int weight) {
+        MinQueue pq;
+        auto seed = [&](int from, int to) {
+            auto df = tree.dist.find(from);
+            if (df == tree.dist.end()) return; // 'from' not reachable yet
+            int nd = df->second + weight;
+            auto dt = tree.dist.find(to);
+            if (dt == tree.dist.end() || nd < dt->second) {
+                tree.dist[to] = nd;
+                tree.parent[to] = from;
+                pq.push({nd, to});
+            }
+        };
+        seed(u, v);
+        seed(v, u);
+        relaxFrom(tree, pq);
+    }
+
+    // Dijkstra over the CSR arrays using Dial's bucket queue: weights are small
+    // integers, so bucket d % (maxWeight + 1) holds every node at distance d.
+    void buildFlatTreeBuckets(FlatPathTree& tree, int source) {
+        int numBuckets = maxWeight + 1;
+        buckets.resize(numBuckets);
+
+        tree.dist[source] = 0;
+        buckets[0].push_back(source);
+        size_t queued = 1;
+
+        for (int d = 0; queued > 0; ++d) {
+            vector<int>& bucket = buckets[d % numBuckets];
+            // Index loop: zero-weight edges append to the bucket being scanned
+            for (size_t i = 0; i < bucket.size(); ++i) {
+                int u = bucket[i];
+                --queued;
+                if (tree.dist[u] != d) continue; // Stale entry
+
+                for (int e = csrStart[u]; e < csrStart[u + 1]; ++e) {
+                    int v = csrTarget[e];
+                    int nd = d + csrWeight[e];
+                    if (tree.dist[v] == -1 || nd < tree.dist[v]) {
+                        tree.dist[v] = nd;
+                        tree.parent[v] = u;
+                        buckets[nd % numBuckets].push_back(v);
+                        ++queued;
+                    }
+                }
+            }
+            bucket.clear();
+        }
+    }
+
+    // Same search with a binary heap, for layouts with large edge weights
+    void buildFlatTreeHeap(FlatPathTree& tree, int source) {
+        MinQueue pq;
+        tree.dist[source] = 0;
+        pq.push({0, source});
+
+        while (!pq.empty()) {
+            int d = pq.top().first;
+            int u = pq.top().second;
+            pq.pop();
+            if (d > tree.dist[u]) continue;
+
+            for (int e = csrStart[u]; e < csrStart[u + 1]; ++e) {
+                int v = csrTarget[e];
+                int nd = d + csrWeight[e];
+                if (tree.dist[v] == -1 || nd < tree.dist[v]) {
+                    tree.dist[v] = nd;
+                    tree.parent[v] = u;
+                    pq.push({nd, v});
+                }
+            }
+        }
+    }
+
+    const FlatPathTree& getFlatTree(int source) {
+        auto it = flatTreeCache.find(source);
+        if (it != flatTreeCache.end()) return it->second;
+
+        if (flatTreeCache.size() >= treeCacheLimit && !flatTreeCacheOrder.empty()) {
+            flatTreeCache.erase(flatTreeCacheOrder.front());
+            flatTreeCacheOrder.pop_front();
+        }
+
+        FlatPathTree& tree = flatTreeCache[source];
+        flatTreeCacheOrder.push_back(source);
+
+        SpanTimer timer(stats, SPAN_DIJKSTRA);
+        tree.dist.assign(denseToNode.size(), -1);
+        tree.parent.assign(denseToNode.size(), -1);
+        if (maxWeight <= MAX_BUCKET_WEIGHT) {
+            buildFlatTreeBuckets(tree, source);
+        } else {
+            buildFlatTreeHeap(tree, source);
+        }
+        return tree;
+    }
+
+    // Returns the dense index of a node, or -1 if it has no edges
+    int denseIndex(int node) const {
+        auto it = nodeToDense.find(node);
+        return it == nodeToDense.end() ? -1 : it->second;
+    }
+
+    void dropCompiled() {
+        compiled = false;
+        denseToNode.clear();
+        nodeToDense.clear();
+        csrStart.clear();
+        csrTarget.clear();
+        csrWeight.clear();
+        flatTreeCache.clear();
+        flatTreeCacheOrder.clear();
+        landmarks.clear();
+        landmarkDist.clear();
+        hierarchy = nullptr;
+    }
+
+    // Lower bound on the distance from dense node v to t by the triangle
+    // inequality over every landmark. -1 if some landmark reaches exactly one
+    // of the two, i.e. they sit in different components.
+    int landmarkBound(int v, int t) const {
+        size_t k = landmarks.size();
+        const int* dv = &landmarkDist[(size_t)v * k];
+        const int* dt = &landmarkDist[(size_t)t * k];
+        int bound = 0;
+        for (size_t i = 0; i < k; ++i) {
+            if ((dv[i] == -1) != (dt[i] == -1)) return -1;
+            if (dv[i] == -1) continue;
+            int diff = dv[i] > dt[i] ? dv[i] - dt[i] : dt[i] - dv[i];
+            if (diff > bound) bound = diff;
+        }
+        return bound;
+    }
+
+    // Per-thread search scratch for the read-only point-to-point queries; the
+    // stamp marks which entries belong to the current query
+    struct SearchScratch {
+        vector<int> dist, parent, bound;
+        vector<unsigned int> stamp;
+        unsigned int currentStamp = 0;
+
+        void begin(size_t n) {
+            if (stamp.size() < n) {
+                dist.resize(n);
+                parent.resize(n);
+                bound.resize(n);
+                stamp.assign(n, 0);
+                currentStamp = 0;
+            }
+            if (++currentStamp == 0) { // Wrapped around
+                fill(stamp.begin(), stamp.end(), 0);
+                currentStamp = 1;
+            }
+        }
+    };
+
+    static SearchScratch& scratch() {
+        thread_local SearchScratch s;
+        return s;
+    }
+
+    pair<int, vector<int>> tracePath(const SearchScratch& sc, int t) const {
+        vector<int> path;
+        if (sc.stamp[t] != sc.currentStamp) return {-1, path}; // Unreachable
+        for (int curr = t; curr != -1; curr = sc.parent[curr]) path.push_back(denseToNode[curr]);
+        reverse(path.begin(), path.end());
+        return {sc.dist[t], path};
+    }
+
 public:
+    void setStats(LatencyStats* s) { stats = s; }
+
     // Add a connection between two locations (undirected)
+    // Note: adding an edge thaws a compiled graph; call compile() again afterwards.
     void addEdge(int u, int v, int weight) {
         adj[u].push_back({v, weight});
         adj[v].push_back({u, weight}); 
+
+        if (compiled) dropCompiled();
+
+        // Keep cached trees valid
+        for (auto& entry : treeCache) {
+            repairTree(entry.second, u, v, weight);
+        }
+    }
+
+    // Bulk insert (layout files): count degrees first so every adjacency vector
+    // is allocated once, and drop the tree caches instead of repairing per edge.
+    void addEdges(const vector<GraphEdge>& edges) {
+        unordered_map<int, int> degree;
+        degree.reserve(adj.size() + edges.size() / 2);
+        for (auto& node : adj) degree[node.first] = (int)node.second.size();
+        for (const GraphEdge& e : edges) {
+            ++degree[e.u];
+            ++degree[e.v];
+        }
+
+        adj.reserve(degree.size());
+        for (auto& d : degree) adj[d.first].reserve(d.second);
+        for (const GraphEdge& e : edges) {
+            adj[e.u].push_back({e.v, e.weight});
+            adj[e.v].push_back({e.u, e.weight});
+        }
+
+        if (compiled) dropCompiled();
+        clearTreeCache();
+    }
+
+    size_t nodeCount() const { return adj.size(); }
+
+    // Freeze the current layout into the compact CSR form.
+    // Queries then run over flat arrays instead of hash maps.
+    void compile() {
+        dropCompiled();
+
+        denseToNode.reserve(adj.size());
+        for (auto& node : adj) denseToNode.push_back(node.first);
+        sort(denseToNode.begin(), denseToNode.end());
+
+        nodeToDense.reserve(denseToNode.size());
+        for (size_t i = 0; i < denseToNode.size(); ++i) {
+            nodeToDense[denseToNode[i]] = (int)i;
+        }
+
+        size_t edgeCount = 0;
+        for (auto& node : adj) edgeCount += node.second.size();
+
+        csrStart.reserve(denseToNode.size() + 1);
+        csrTarget.reserve(edgeCount);
+        csrWeight.reserve(edgeCount);
+        maxWeight = 0;
+
+        for (int node : denseToNode) {
+            csrStart.push_back((int)csrTarget.size());
+            for (auto& edge : adj[node]) {
+                csrTarget.push_back(nodeToDense[edge.first]);
+                csrWeight.push_back(edge.second);
+                maxWeight = max(maxWeight, edge.second);
+            }
+        }
+        csrStart.push_back((int)csrTarget.size());
+
+        compiled = true;
+    }
+
+    bool isCompiled() const { return compiled; }
+
+    // Returns the (cached) shortest-path tree rooted at source
+    const ShortestPathTree& getShortestPathTree(int source) {
+        auto it = treeCache.find(source);
+        if (it != treeCache.end()) return it->second;
+        return buildTree(source);
+    }
+
+    // Distance-only query for callers that don't need the path.
+    // Returns -1 if end is unreachable.
+    int getDistance(int start, int end) {
+        if (compiled) {
+            int s = denseIndex(start), t = denseIndex(end);
+            if (s == -1 || t == -1) return start == end ? 0 : -1;
+            return getFlatTree(s).dist[t];
+        }
+
+        const ShortestPathTree& tree = getShortestPathTree(start);
+        auto it = tree.dist.find(end);
+        return it == tree.dist.end() ? -1 : it->second;
     }
 
     // Dijkstra's Algorithm to find shortest path from startNode to endNode
     // Returns pair<TotalDistance, PathVector>
     pair<int, vector<int>> getShortestPath(int start, int end) {
-        unordered_map<int, int> dist;
-        unordered_map<int, int> parent;
+        // With a hierarchy attached it answers every path query, cached tree or
+        // not: equal-cost routes can differ between the two, and the route must
+        // not depend on which queries ran first (same as findPath)
+        if (hierarchy) {
+            SpanTimer timer(stats, SPAN_DIJKSTRA);
+            return hierarchy->query(start, end);
+        }
+        if (compiled) return getShortestPathCompiled(start, end);
+
+        const ShortestPathTree& tree = getShortestPathTree(start);
+
+        // Reconstruct path
+        vector<int> path;
+        auto it = tree.dist.find(end);
+        if (it == tree.dist.end()) {
+            return {-1, path}; // Unreachable
+        }
+
+        int curr = end;
+        while (curr != start) {
+            path.push_back(curr);
+            auto p = tree.parent.find(curr);
+            if (p == tree.parent.end()) break; // Should not happen if path exists
+            curr = p->second;
+        }
+        path.push_back(start);
+        reverse(path.begin(), path.end());
         
-        // Initialize distances to infinity
-        for (auto& node : adj) {
-            dist[node.first] = numeric_limits<int>::max();
+        return {it->second, path};
+    }
+
+    // Compiled-mode variant of getShortestPath, same result contract
+    pair<int, vector<int>> getShortestPathCompiled(int start, int end) {
+        vector<int> path;
+        int s = denseIndex(start), t = denseIndex(end);
+        if (s == -1 || t == -1) {
+            if (start != end) return {-1, path};
+            path.push_back(start);
+            return {0, path};
+        }
+
+        const FlatPathTree& tree = getFlatTree(s);
+        if (tree.dist[t] == -1) {
+            return {-1, path}; // Unreachable
+        }
+
+        for (int curr = t; curr != -1; curr = tree.parent[curr]) {
+            path.push_back(denseToNode[curr]);
+        }
+        reverse(path.begin(), path.end());
+        return {tree.dist[t], path};
+    }
+
+    // Point-to-point query that neither reads nor fills the tree caches, so
+    // several threads may call it at once as long as nobody calls
+    // addEdge/compile/buildLandmarks meanwhile. Same result contract as
+    // getShortestPath. Uses the contraction hierarchy if one is attached, A*
+    // over the landmarks once they are built, plain Dijkstra otherwise. If
+    // 'settled' is given it receives the number of nodes the search settled.
+    pair<int, vector<int>> findPath(int start, int end, size_t* settled = nullptr) const {
+        if (hierarchy) {
+            SpanTimer timer(stats, SPAN_DIJKSTRA);
+            return hierarchy->query(start, end, settled);
+        }
+        if (!landmarks.empty()) return findPathALT(start, end, settled);
+        return findPathDijkstra(start, end, settled);
+    }
+
+    // "ch", "alt" or "dijkstra": what findPath will use
+    const char* routingMode() const {
+        return hierarchy ? "ch" : !landmarks.empty() ? "alt" : "dijkstra";
+    }
+
+    // Dijkstra with early exit at end
+    pair<int, vector<int>> findPathDijkstra(int start, int end, size_t* settled = nullptr) const {
+        SpanTimer timer(stats, SPAN_DIJKSTRA);
+        size_t settledCount = 0;
+        vector<int> path;
+        if (settled) *settled = 0;
+        if (start == end) {
+            path.push_back(start);
+            return {0, path};
+        }
+
+        if (compiled) {
+            int s = denseIndex(start), t = denseIndex(end);
+            if (s == -1 || t == -1) return {-1, path};
+
+            SearchScratch& sc = scratch();
+            sc.begin(denseToNode.size());
+
+            MinQueue pq;
+            sc.dist[s] = 0;
+            sc.parent[s] = -1;
+            sc.stamp[s] = sc.currentStamp;
+            pq.push({0, s});
+            while (!pq.empty()) {
+                int d = pq.top().first;
+                int u = pq.top().second;
+                pq.pop();
+                if (d > sc.dist[u]) continue;
+                ++settledCount;
+                if (u == t) break;
+
+                for (int e = csrStart[u]; e < csrStart[u + 1]; ++e) {
+                    int v = csrTarget[e];
+                    int nd = d + csrWeight[e];
+                    if (sc.stamp[v] != sc.currentStamp || nd < sc.dist[v]) {
+                        sc.stamp[v] = sc.currentStamp;
+                        sc.dist[v] = nd;
+                        sc.parent[v] = u;
+                        pq.push({nd, v});
+                    }
+                }
+            }
+            if (settled) *settled = settledCount;
+            return tracePath(sc, t);
         }
-        // Ensure start/end are in the map even if they have no connections yet (safety check)
-        if (dist.find(start) == dist.end()) dist[start] = numeric_limits<int>::max();
-        if (dist.find(end) == dist.end()) dist[end] = numeric_limits<int>::max();
 
+        unordered_map<int, int> dist;
+        unordered_map<int, int> parent;
+        MinQueue pq;
         dist[start] = 0;
-        
-        // Min-Priority Queue for Dijkstra: {distance, node}
-        priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> pq;
         pq.push({0, start});
-
         while (!pq.empty()) {
             int d = pq.top().first;
             int u = pq.top().second;
             pq.pop();
-
-            // If we found a shorter path before, skip this stale entry
             if (d > dist[u]) continue;
-            
-            // Reached destination?
-            if (u == end) break; 
-
-            if (adj.find(u) != adj.end()) {
-                for (auto& edge : adj[u]) {
-                    int v = edge.first;
-                    int weight = edge.second;
-                    
-                    // Initialize neighbor if not seen
-                    if (dist.find(v) == dist.end()) dist[v] = numeric_limits<int>::max();
-                    
-                    if (dist[u] != numeric_limits<int>::max() && dist[u] + weight < dist[v]) {
-                        dist[v] = dist[u] + weight;
-                        parent[v] = u;
-                        pq.push({dist[v], v});
-                    }
+            ++settledCount;
+            if (u == end) break;
+
+            auto it = adj.find(u);
+            if (it == adj.end()) continue;
+            for (auto& edge : it->second) {
+                int nd = d + edge.second;
+                auto dv = dist.find(edge.first);
+                if (dv == dist.end() || nd < dv->second) {
+                    dist[edge.first] = nd;
+                    parent[edge.first] = u;
+                    pq.push({nd, edge.first});
                 }
             }
         }
+        if (settled) *settled = settledCount;
 
-        // Reconstruct path
+        auto de = dist.find(end);
+        if (de == dist.end()) return {-1, path};
+        for (int curr = end; curr != start; curr = parent.at(curr)) path.push_back(curr);
+        path.push_back(start);
+        reverse(path.begin(), path.end());
+        return {de->second, path};
+    }
+
+    // A* with the landmark lower bounds as heuristic (ALT). The bound is
+    // consistent on an undirected graph, so every node settles at most once
+    // and the first time end is popped its distance is final. Falls back to
+    // Dijkstra if no landmarks are built.
+    pair<int, vector<int>> findPathALT(int start, int end, size_t* settled = nullptr) const {
+        if (landmarks.empty()) return findPathDijkstra(start, end, settled);
+        SpanTimer timer(stats, SPAN_DIJKSTRA);
+        size_t settledCount = 0;
         vector<int> path;
-        if (dist[end] == numeric_limits<int>::max()) {
-            return {-1, path}; // Unreachable
+        if (settled) *settled = 0;
+        if (start == end) {
+            path.push_back(start);
+            return {0, path};
         }
 
-        int curr = end;
-        while (curr != start) {
-            path.push_back(curr);
-            if (parent.find(curr) == parent.end()) break; // Should not happen if path exists
-            curr = parent[curr];
+        int s = denseIndex(start), t = denseIndex(end);
+        if (s == -1 || t == -1) return {-1, path};
+
+        int h = landmarkBound(s, t);
+        if (h == -1) return {-1, path}; // Different components: nothing to search
+
+        SearchScratch& sc = scratch();
+        sc.begin(denseToNode.size());
+
+        // Queue holds {dist + bound, node}
+        MinQueue pq;
+        sc.dist[s] = 0;
+        sc.parent[s] = -1;
+        sc.bound[s] = h;
+        sc.stamp[s] = sc.currentStamp;
+        pq.push({h, s});
+        while (!pq.empty()) {
+            int f = pq.top().first;
+            int u = pq.top().second;
+            pq.pop();
+            if (f > sc.dist[u] + sc.bound[u]) continue; // Stale entry
+            ++settledCount;
+            if (u == t) break;
+
+            for (int e = csrStart[u]; e < csrStart[u + 1]; ++e) {
+                int v = csrTarget[e];
+                int nd = sc.dist[u] + csrWeight[e];
+                if (sc.stamp[v] != sc.currentStamp) {
+                    sc.stamp[v] = sc.currentStamp;
+                    sc.bound[v] = landmarkBound(v, t);
+                } else if (nd >= sc.dist[v]) {
+                    continue;
+                }
+                sc.dist[v] = nd;
+                sc.parent[v] = u;
+                pq.push({nd + sc.bound[v], v});
+            }
         }
-        path.push_back(start);
-        reverse(path.begin(), path.end());
-        
-        return {dist[end], path};
+        if (settled) *settled = settledCount;
+        return tracePath(sc, t);
+    }
+
+    // ALT preprocessing: pick 'count' landmarks by farthest-point selection and
+    // store every node's distance to each (one full search per landmark,
+    // 4 * count bytes per node). The first landmark is the node farthest from
+    // the lowest-numbered node; each next one is the node farthest from all
+    // landmarks so far, which favours the ends of long aisles where the bounds
+    // are tightest. Compiles the graph if needed; adding an edge drops the
+    // landmarks along with the compiled form. count 0 turns ALT off.
+    void buildLandmarks(size_t count) {
+        if (!compiled) compile();
+        landmarks.clear();
+        landmarkDist.clear();
+        size_t n = denseToNode.size();
+        if (count == 0 || n == 0) return;
+        count = min(count, n);
+
+        SpanTimer timer(stats, SPAN_DIJKSTRA);
+        vector<vector<int>> tables;
+        vector<long long> nearest(n, numeric_limits<long long>::max()); // Distance to the closest landmark so far
+
+        FlatPathTree probe;
+        probe.dist.assign(n, -1);
+        probe.parent.assign(n, -1);
+        if (maxWeight <= MAX_BUCKET_WEIGHT) buildFlatTreeBuckets(probe, 0); else buildFlatTreeHeap(probe, 0);
+        int next = (int)(max_element(probe.dist.begin(), probe.dist.end()) - probe.dist.begin());
+
+        while (landmarks.size() < count) {
+            landmarks.push_back(next);
+            FlatPathTree tree;
+            tree.dist.assign(n, -1);
+            tree.parent.assign(n, -1);
+            if (maxWeight <= MAX_BUCKET_WEIGHT) buildFlatTreeBuckets(tree, next); else buildFlatTreeHeap(tree, next);
+
+            // Unreachable nodes keep "infinitely far", so other components get a landmark of their own
+            long long farthest = -1;
+            for (size_t v = 0; v < n; ++v) {
+                if (tree.dist[v] != -1) nearest[v] = min(nearest[v], (long long)tree.dist[v]);
+                if (nearest[v] > farthest) {
+                    farthest = nearest[v];
+                    next = (int)v;
+                }
+            }
+            tables.push_back(std::move(tree.dist));
+            if (farthest <= 0) break; // Every node already is a landmark
+        }
+
+        size_t k = landmarks.size();
+        landmarkDist.resize(n * k);
+        for (size_t v = 0; v < n; ++v) {
+            for (size_t i = 0; i < k; ++i) landmarkDist[v * k + i] = tables[i][v];
+        }
+    }
+
+    size_t landmarkCount() const { return landmarks.size(); }
+
+    // --- Contraction hierarchy ---
+
+    // Fingerprint of the compiled layout; an index only fits the layout it was built from
+    uint64_t layoutFingerprint() {
+        if (!compiled) compile();
+        return ContractionHierarchy::fingerprint(denseToNode, csrStart, csrTarget, csrWeight);
+    }
+
+    // Contract the current layout into 'ch' (compiles first if needed). Slow:
+    // meant for an offline build whose result is saved and mapped later.
+    void buildHierarchy(ContractionHierarchy& ch) {
+        if (!compiled) compile();
+        SpanTimer timer(stats, SPAN_DIJKSTRA);
+        ch.build(denseToNode, csrStart, csrTarget, csrWeight);
+    }
+
+    // Route point-to-point queries through 'ch' (nullptr detaches). Refused if
+    // the index was built for a different layout. The index must outlive the
+    // graph's use of it; adding an edge detaches it.
+    bool attachHierarchy(const ContractionHierarchy* ch) {
+        if (ch && (ch->empty() || ch->layoutFingerprint() != layoutFingerprint())) return false;
+        hierarchy = ch;
+        return true;
+    }
+
+    bool hasHierarchy() const { return hierarchy != nullptr; }
+    size_t landmarkBytes() const { return landmarkDist.size() * sizeof(int); }
+
+    // Distances from source to every node in targets (-1 if unreachable), read
+    // off source's shortest-path tree, built once and cached. For a source that
+    // is queried over and over (the depot) this beats a fresh multi-target search.
+    vector<int> getTreeDistances(int source, const vector<int>& targets) {
+        vector<int> result(targets.size(), -1);
+        if (compiled) {
+            int s = denseIndex(source);
+            for (size_t i = 0; i < targets.size(); ++i) {
+                int t = denseIndex(targets[i]);
+                if (s == -1 || t == -1) result[i] = source == targets[i] ? 0 : -1;
+                else result[i] = getFlatTree(s).dist[t];
+            }
+            return result;
+        }
+
+        const ShortestPathTree& tree = getShortestPathTree(source);
+        for (size_t i = 0; i < targets.size(); ++i) {
+            auto it = tree.dist.find(targets[i]);
+            result[i] = it == tree.dist.end() ? -1 : it->second;
+        }
+        return result;
+    }
+
+    // Multi-target Dijkstra: distances from source to every node in targets
+    // (-1 if unreachable). Stops as soon as all targets are settled, so it is
+    // much cheaper than a full tree when the targets are close together.
+    vector<int> getDistancesTo(int source, const vector<int>& targets) {
+        vector<int> result(targets.size(), -1);
+        if (targets.empty()) return result;
+
+        // A cached tree for the source (usually the depot) already has the answer
+        if (compiled ? flatTreeCache.count(denseIndex(source)) > 0 : treeCache.count(source) > 0) {
+            return getTreeDistances(source, targets);
+        }
+        SpanTimer timer(stats, SPAN_DIJKSTRA);
+
+        // Target node -> positions in result (targets may repeat)
+        unordered_map<int, vector<int>> wanted;
+        for (size_t i = 0; i < targets.size(); ++i) wanted[targets[i]].push_back((int)i);
+        size_t remaining = wanted.size();
+
+        auto settle = [&](int node, int d) {
+            auto w = wanted.find(node);
+            if (w == wanted.end()) return;
+            for (int idx : w->second) result[idx] = d;
+            wanted.erase(w);
+            --remaining;
+        };
+
+        MinQueue pq;
+
+        if (compiled) {
+            int s = denseIndex(source);
+            if (s == -1) {
+                settle(source, 0);
+                return result;
+            }
+            vector<int> dist(denseToNode.size(), -1);
+            dist[s] = 0;
+            pq.push({0, s});
+            while (!pq.empty() && remaining > 0) {
+                int d = pq.top().first;
+                int u = pq.top().second;
+                pq.pop();
+                if (d > dist[u]) continue;
+                settle(denseToNode[u], d);
+
+                for (int e = csrStart[u]; e < csrStart[u + 1]; ++e) {
+                    int v = csrTarget[e];
+                    int nd = d + csrWeight[e];
+                    if (dist[v] == -1 || nd < dist[v]) {
+                        dist[v] = nd;
+                        pq.push({nd, v});
+                    }
+                }
+            }
+            return result;
+        }
+
+        unordered_map<int, int> dist;
+        dist[source] = 0;
+        pq.push({0, source});
+        while (!pq.empty() && remaining > 0) {
+            int d = pq.top().first;
+            int u = pq.top().second;
+            pq.pop();
+            if (d > dist[u]) continue;
+            settle(u, d);
+
+            auto it = adj.find(u);
+            if (it == adj.end()) continue;
+            for (auto& edge : it->second) {
+                int nd = d + edge.second;
+                auto dv = dist.find(edge.first);
+                if (dv == dist.end() || nd < dv->second) {
+                    dist[edge.first] = nd;
+                    pq.push({nd, edge.first});
+                }
+            }
+        }
+        return result;
+    }
+
+    // Pairwise distance matrix over a set of nodes, one multi-target search per row
+    vector<vector<int>> getDistanceMatrix(const vector<int>& nodes) {
+        vector<vector<int>> matrix;
+        matrix.reserve(nodes.size());
+        for (int node : nodes) {
+            matrix.push_back(getDistancesTo(node, nodes));
+        }
+        return matrix;
+    }
+
+    // Max number of source trees kept in the cache (oldest evicted first)
+    void setTreeCacheLimit(size_t limit) {
+        treeCacheLimit = limit > 0 ? limit : 1;
+        while (treeCache.size() > treeCacheLimit) {
+            treeCache.erase(treeCacheOrder.front());
+            treeCacheOrder.pop_front();
+        }
+        while (flatTreeCache.size() > treeCacheLimit) {
+            flatTreeCache.erase(flatTreeCacheOrder.front());
+            flatTreeCacheOrder.pop_front();
+        }
+    }
+
+    void clearTreeCache() {
+        treeCache.clear();
+        treeCacheOrder.clear();
+        flatTreeCache.clear();
+        flatTreeCacheOrder.clear();
     }
 
     void displayGraph() {
@@ -0,0 +1,119 @@
+#ifndef WAVEPLANNER_H
+#define WAVEPLANNER_H
+
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+using namespace std;
+
+// Plans a picker tour over a small set of stops (a pick wave).
+// Works on a symmetric distance matrix where index 0 is the depot;
+// tours start and end at the depot: [0, s1, s2, ..., sn, 0].
+class WavePlanner {
+private:
+    const vector<vector<int>>& dist;
+    chrono::steady_clock::time_point deadline;
+
+    bool outOfTime() const {
+        return chrono::steady_clock::now() >= deadline;
+    }
+
+    // Reverse tour[i..j] whenever that shortens the tour
+    bool improve2Opt(vector<int>& tour) {
+        bool improved = false;
+        int n = (int)tour.size();
+        for (int i = 1; i < n - 2; ++i) {
+            if (outOfTime()) return improved;
+            for (int j = i + 1; j < n - 1; ++j) {
+                int a = tour[i - 1], b = tour[i], c = tour[j], d = tour[j + 1];
+                int delta = dist[a][c] + dist[b][d] - dist[a][b] - dist[c][d];
+                if (delta < 0) {
+                    reverse(tour.begin() + i, tour.begin() + j + 1);
+                    improved = true;
+                }
+            }
+        }
+        return improved;
+    }
+
+    // Move a run of 1-3 stops to a better place in the tour (optionally reversed)
+    bool improveOrOpt(vector<int>& tour) {
+        bool improved = false;
+        int n = (int)tour.size();
+        for (int len = 1; len <= 3; ++len) {
+            for (int i = 1; i + len < n; ++i) {
+                if (outOfTime()) return improved;
+                int p = tour[i - 1], first = tour[i], last = tour[i + len - 1], nx = tour[i + len];
+                int removeGain = dist[p][first] + dist[last][nx] - dist[p][nx];
+
+                for (int j = 0; j < n - 1; ++j) {
+                    if (j >= i - 1 && j <= i + len - 1) continue; // Edge touches the segment
+                    int a = tour[j], b = tour[j + 1];
+                    int forward = dist[a][first] + dist[last][b] - dist[a][b];
+                    int backward = dist[a][last] + dist[first][b] - dist[a][b];
+                    int insertCost = min(forward, backward);
+                    if (insertCost >= removeGain) continue;
+
+                    vector<int> segment(tour.begin() + i, tour.begin() + i + len);
+                    if (backward < forward) reverse(segment.begin(), segment.end());
+
+                    vector<int> next;
+                    next.reserve(n);
+                    for (int k = 0; k < n; ++k) {
+                        if (k >= i && k < i + len) continue;
+                        next.push_back(tour[k]);
+                        if (k == j) next.insert(next.end(), segment.begin(), segment.end());
+                    }
+                    tour.swap(next);
+                    improved = true;
+                    break;
+                }
+            }
+        }
+        return improved;
+    }
+
+public:
+    WavePlanner(const vector<vector<int>>& matrix) : dist(matrix) {}
+
+    // Greedy start: always walk to the closest unvisited stop
+    vector<int> nearestNeighbourTour() {
+        int n = (int)dist.size();
+        vector<int> tour;
+        vector<bool> visited(n, false);
+        tour.push_back(0);
+        visited[0] = true;
+
+        for (int step = 1; step < n; ++step) {
+            int from = tour.back(), best = -1;
+            for (int to = 1; to < n; ++to) {
+                if (!visited[to] && (best == -1 || dist[from][to] < dist[from][best])) best = to;
+            }
+            tour.push_back(best);
+            visited[best] = true;
+        }
+        tour.push_back(0);
+        return tour;
+    }
+
+    // Nearest neighbour, then 2-opt / Or-opt passes until no gain or time runs out
+    vector<int> plan(int budgetMs) {
+        deadline = chrono::steady_clock::now() + chrono::milliseconds(budgetMs);
+        vector<int> tour = nearestNeighbourTour();
+        while (!outOfTime()) {
+            bool improved = improve2Opt(tour);
+            improved = improveOrOpt(tour) || improved;
+            if (!improved) break;
+        }
+        return tour;
+    }
+
+    int tourLength(const vector<int>& tour) const {
+        int total = 0;
+        for (size_t i = 1; i < tour.size(); ++i) total += dist[tour[i - 1]][tour[i]];
+        return total;
+    }
+};
+
+#endif
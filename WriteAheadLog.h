@@ -0,0 +1,214 @@
+#ifndef WRITEAHEADLOG_H
+#define WRITEAHEADLOG_H
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include "BinaryIO.h"
+#include "MappedFile.h"
+
+using namespace std;
+
+// Mutations recorded in the log (API mode commands that change state)
+enum WalOp : uint8_t {
+    WAL_ADD_ORDER = 1,     // itemId, qty, prio
+    WAL_PROCESS,           // -
+    WAL_DISPATCH,          // -
+    WAL_UNDO,              // -
+    WAL_CANCEL_ORDER,      // orderId
+    WAL_UPDATE_PRIORITY,   // orderId, prio
+    WAL_PROCESS_IDS,       // orderId... moved to dispatch in this order (waves, pipeline)
+    WAL_ADD_STOCK,         // itemId, node, qty
+    WAL_ADD_ORDERS         // (itemId, qty, prio)... placed as one batch
+};
+
+struct WalRecord {
+    uint64_t lsn;
+    WalOp op;
+    vector<int32_t> args;
+};
+
+// Append-only binary log of mutations with group commit.
+//
+// Record layout: [u32 bodyLen][body][u32 checksum(body)], where
+// body = [u64 lsn][u8 op][u32 argc][i32 args...].
+// A torn or corrupt tail (crash mid-write) ends the log at the last good record.
+//
+// append() only buffers. A background thread writes the buffer and fsyncs every
+// syncIntervalMs, so many records share one fsync (0 = sync on every append).
+// The commit is asynchronous: callers reply as soon as append() returns, so a
+// crash can lose up to syncIntervalMs of mutations that were already
+// acknowledged. Use a window of 0 when every reply must be durable.
+class WriteAheadLog {
+private:
+    string path;
+    FILE* file = nullptr;
+    uint64_t nextLsn = 1;
+    size_t recordsSinceReset = 0;
+    int syncIntervalMs = 5;
+
+    mutex lock;
+    condition_variable wake;
+    vector<char> pending;       // Appended but not yet written
+    bool stopping = false;
+    thread flusher;
+
+    // Caller holds 'lock'
+    void writePendingLocked() {
+        if (pending.empty() || !file) return;
+        fwrite(pending.data(), 1, pending.size(), file);
+        pending.clear();
+        syncFile(file);
+    }
+
+    void flushLoop() {
+        unique_lock<mutex> lk(lock);
+        while (!stopping) {
+            wake.wait_for(lk, chrono::milliseconds(syncIntervalMs));
+            writePendingLocked();
+        }
+        writePendingLocked();
+    }
+
+public:
+    WriteAheadLog() {}
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    ~WriteAheadLog() {
+        close();
+    }
+
+    // Parse every intact record in a log file. Returns false if it can't be read.
+    // validBytes receives the length of the intact prefix.
+    static bool readAll(const string& logPath, vector<WalRecord>& out, size_t& validBytes) {
+        validBytes = 0;
+        MappedFile mf;
+        if (!mf.open(logPath)) return false;
+
+        BinaryReader rd(mf.data(), mf.size());
+        while (rd.remaining() >= 4) {
+            uint32_t bodyLen = rd.get<uint32_t>();
+            if (rd.remaining() < (size_t)bodyLen + 4) break; // Torn tail
+            const char* body = rd.current();
+            rd.skip(bodyLen);
+            uint32_t sum = rd.get<uint32_t>();
+            if (sum != checksum32(body, bodyLen)) break;
+
+            BinaryReader br(body, bodyLen);
+            WalRecord rec;
+            rec.lsn = br.get<uint64_t>();
+            rec.op = (WalOp)br.get<uint8_t>();
+            uint32_t argc = br.get<uint32_t>();
+            for (uint32_t i = 0; i < argc && br.ok; ++i) rec.args.push_back(br.get<int32_t>());
+            if (!br.ok) break;
+
+            out.push_back(rec);
+            validBytes = (size_t)(rd.current() - mf.data());
+        }
+        return true;
+    }
+
+    // Open for appending. Drops any torn tail and continues numbering after
+    // max(last LSN in the file, minLsn - 1).
+    bool open(const string& logPath, int syncMs, uint64_t minLsn) {
+        close();
+        path = logPath;
+        syncIntervalMs = syncMs;
+
+        vector<WalRecord> existing;
+        size_t validBytes = 0;
+        bool exists = readAll(path, existing, validBytes);
+
+        nextLsn = minLsn > 0 ? minLsn : 1;
+        if (!existing.empty() && existing.back().lsn >= nextLsn) nextLsn = existing.back().lsn + 1;
+        recordsSinceReset = existing.size();
+
+        if (exists) {
+            // Rewrite the intact prefix if the tail was torn
+            MappedFile mf;
+            mf.open(path);
+            if (mf.size() != validBytes) {
+                vector<char> keep(mf.data(), mf.data() + validBytes);
+                mf.close();
+                writeFileAtomic(path, keep);
+            }
+        }
+
+        file = fopen(path.c_str(), "ab");
+        if (!file) return false;
+
+        stopping = false;
+        if (syncIntervalMs > 0) flusher = thread(&WriteAheadLog::flushLoop, this);
+        return true;
+    }
+
+    bool isOpen() const { return file != nullptr; }
+
+    // Buffer one record; returns its LSN
+    uint64_t append(WalOp op, const vector<int32_t>& args) {
+        BinaryWriter body;
+        lock_guard<mutex> lk(lock);
+        uint64_t lsn = nextLsn++;
+        body.put<uint64_t>(lsn);
+        body.put<uint8_t>(op);
+        body.put<uint32_t>((uint32_t)args.size());
+        for (int32_t a : args) body.put<int32_t>(a);
+
+        BinaryWriter rec;
+        rec.put<uint32_t>((uint32_t)body.size());
+        rec.putBytes(body.buffer.data(), body.size());
+        rec.put<uint32_t>(checksum32(body.buffer.data(), body.size()));
+        pending.insert(pending.end(), rec.buffer.begin(), rec.buffer.end());
+        ++recordsSinceReset;
+
+        if (syncIntervalMs <= 0) writePendingLocked();
+        return lsn;
+    }
+
+    // Write and fsync everything buffered so far
+    void sync() {
+        lock_guard<mutex> lk(lock);
+        writePendingLocked();
+    }
+
+    // After a snapshot covering every record so far: start the log over empty
+    void reset() {
+        lock_guard<mutex> lk(lock);
+        pending.clear();
+        if (file) fclose(file);
+        file = fopen(path.c_str(), "wb");
+        if (file) syncFile(file);
+        recordsSinceReset = 0;
+    }
+
+    uint64_t lastLsn() {
+        lock_guard<mutex> lk(lock);
+        return nextLsn - 1;
+    }
+
+    size_t recordCount() {
+        lock_guard<mutex> lk(lock);
+        return recordsSinceReset;
+    }
+
+    void close() {
+        {
+            lock_guard<mutex> lk(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        if (flusher.joinable()) flusher.join();
+        lock_guard<mutex> lk(lock);
+        writePendingLocked();
+        if (file) fclose(file);
+        file = nullptr;
+    }
+};
+
+#endif
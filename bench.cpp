@@ -0,0 +1,475 @@
+// Microbenchmarks for the core data structures.
+//
+// Standalone target, built separately from main.cpp with optimizations on:
+//   g++ -std=c++17 -O2 -pthread bench.cpp -o bench
+//
+// Usage: bench [name-filter] [--max-scale N] [--budget-ms N]
+// Prints one JSON object per line (benchmark, scale, ops, nsPerOp, opsPerSec,
+// allocsPerOp) so results can be diffed or loaded into a spreadsheet.
+//
+//        bench --stress [--threads N]
+// Many threads reserving the same few SKUs at once; exits 1 if stock was
+// oversold or lost (final stock + everything reserved != starting stock).
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
+#include <atomic>
+#include <thread>
+#include <cstdlib>
+#include <new>
+#include "Order.h"
+#include "WarehouseGraph.h"
+#include "InventoryManager.h"
+#include "ProductCatalog.h"
+#include "ActionHistory.h"
+#include "OrderManager.h"
+#include "StateJSON.h"
+#include "StateSerializer.h"
+
+using namespace std;
+
+// --- Allocation counting: every operator new in the process goes through here ---
+static atomic<size_t> allocationCount(0);
+
+// new and delete stay out of line: once malloc()/free() are inlined into a
+// caller, GCC warns they don't match operator new/delete (-Wmismatched-new-delete)
+__attribute__((noinline)) void* operator new(size_t size) {
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+__attribute__((noinline)) void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { operator delete(p); }
+void operator delete(void* p, size_t) noexcept { operator delete(p); }
+void operator delete[](void* p, size_t) noexcept { operator delete(p); }
+
+// Swallows cout while a benchmark prints (processNextOrder, GET_STATE)
+class NullBuffer : public streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    streamsize xsputn(const char*, streamsize n) override { return n; }
+};
+
+struct BenchConfig {
+    string filter;
+    size_t maxScale = 1000000;
+    double budgetMs = 300; // Per benchmark and scale
+};
+
+BenchConfig config;
+
+// Runs op(i) for i = 0.. until maxOps calls or the time budget is spent
+// (always at least one call), then prints the result line.
+template <typename Op>
+void runBench(const string& name, size_t scale, size_t maxOps, Op op) {
+    if (!config.filter.empty() && name.find(config.filter) == string::npos) return;
+
+    NullBuffer sink;
+    streambuf* saved = cout.rdbuf(&sink);
+
+    size_t allocsBefore = allocationCount.load();
+    auto start = chrono::steady_clock::now();
+    double elapsedMs = 0;
+    size_t ops = 0;
+    while (ops < maxOps) {
+        op(ops++);
+        // Reading the clock costs ~20ns; only do it every 16 ops
+        if ((ops & 15) == 0 || ops == 1) {
+            elapsedMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            if (elapsedMs > config.budgetMs) break;
+        }
+    }
+    elapsedMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    size_t allocs = allocationCount.load() - allocsBefore;
+
+    cout.rdbuf(saved);
+    double nsPerOp = elapsedMs * 1e6 / ops;
+    cout << "{\"benchmark\": \"" << name << "\", \"scale\": " << scale
+         << ", \"ops\": " << ops
+         << ", \"nsPerOp\": " << nsPerOp
+         << ", \"opsPerSec\": " << (nsPerOp > 0 ? 1e9 / nsPerOp : 0)
+         << ", \"allocsPerOp\": " << (double)allocs / ops << "}" << endl;
+}
+
+// --- Synthetic data ---
+
+// side x side grid, 4-neighbour, weights 1..9
+void buildGrid(WarehouseGraph& graph, size_t nodes, mt19937& rng) {
+    int side = 1;
+    while ((size_t)(side + 1) * (side + 1) <= nodes) ++side;
+    vector<GraphEdge> edges;
+    for (int r = 0; r < side; ++r) {
+        for (int c = 0; c < side; ++c) {
+            int id = r * side + c;
+            if (c + 1 < side) edges.push_back({id, id + 1, (int)(rng() % 9) + 1});
+            if (r + 1 < side) edges.push_back({id, id + side, (int)(rng() % 9) + 1});
+        }
+    }
+    graph.addEdges(edges);
+}
+
+// Long, narrow layout: 'rows' aisles of n / rows nodes with cross-links, weights 1..9
+void buildCorridor(WarehouseGraph& graph, size_t nodes, int rows, mt19937& rng) {
+    int cols = (int)max<size_t>(1, nodes / rows);
+    vector<GraphEdge> edges;
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+            int id = r * cols + c;
+            if (c + 1 < cols) edges.push_back({id, id + 1, (int)(rng() % 9) + 1});
+            if (r + 1 < rows) edges.push_back({id, id + cols, (int)(rng() % 9) + 1});
+        }
+    }
+    graph.addEdges(edges);
+}
+
+// Random connected graph: a spanning chain plus 2n random edges, weights 1..99
+void buildRandomGraph(WarehouseGraph& graph, size_t nodes, mt19937& rng) {
+    vector<GraphEdge> edges;
+    for (size_t i = 1; i < nodes; ++i) edges.push_back({(int)(rng() % i), (int)i, (int)(rng() % 99) + 1});
+    for (size_t i = 0; i < 2 * nodes; ++i) {
+        edges.push_back({(int)(rng() % nodes), (int)(rng() % nodes), (int)(rng() % 99) + 1});
+    }
+    graph.addEdges(edges);
+}
+
+Order makeOrder(int id, mt19937& rng, size_t locations) {
+    Order o;
+    o.id = id;
+    o.priority = (int)(rng() % 10);
+    o.itemId = 101;
+    o.itemName = "Laptop";
+    o.quantity = 1;
+    o.itemLocationNode = (int)(rng() % locations);
+    return o;
+}
+
+void fillInventory(InventoryManager& inv, size_t n) {
+    inv.reserve(n);
+    for (size_t i = 0; i < n; ++i) inv.addItem((int)i, "Item " + to_string(i), 1000000, (int)(i % 1000));
+}
+
+const char* CATEGORIES[] = {"Electronics", "Accessories", "Audio", "Furniture", "Toys", "Garden"};
+
+// --- Benchmarks ---
+
+void benchGraph(size_t n) {
+    mt19937 rng(42);
+    for (int layout = 0; layout < 2; ++layout) {
+        WarehouseGraph graph;
+        if (layout == 0) buildGrid(graph, n, rng); else buildRandomGraph(graph, n, rng);
+        string prefix = layout == 0 ? "graph.shortestPath.grid" : "graph.shortestPath.random";
+        int nodes = (int)graph.nodeCount();
+
+        // Depot queries hit the cached tree after the first one
+        runBench(prefix + ".depot", n, 100000, [&](size_t) {
+            graph.getShortestPath(0, (int)(rng() % nodes));
+        });
+        // Random sources mostly miss the tree cache: one full Dijkstra each
+        runBench(prefix + ".randomSource", n, 100000, [&](size_t) {
+            graph.getShortestPath((int)(rng() % nodes), (int)(rng() % nodes));
+        });
+
+        graph.compile();
+        graph.clearTreeCache();
+        runBench(prefix + ".compiled.randomSource", n, 100000, [&](size_t) {
+            graph.getShortestPath((int)(rng() % nodes), (int)(rng() % nodes));
+        });
+    }
+}
+
+// Point-to-point queries between arbitrary nodes (picker -> bin): Dijkstra
+// with early exit vs A* over 8 landmarks, plus how many nodes each settles
+void benchRouting(size_t n) {
+    mt19937 rng(3);
+    WarehouseGraph graph;
+    buildCorridor(graph, n, 8, rng);
+    graph.compile();
+    int nodes = (int)graph.nodeCount();
+
+    for (int alt = 0; alt < 2; ++alt) {
+        string name = alt ? "graph.pointToPoint.alt" : "graph.pointToPoint.dijkstra";
+        if (!config.filter.empty() && name.find(config.filter) == string::npos) continue;
+        if (alt) graph.buildLandmarks(8);
+
+        mt19937 queries(99); // Same pairs for both
+        size_t settled = 0, total = 0, ops = 0;
+        runBench(name, n, 100000, [&](size_t) {
+            graph.findPath((int)(queries() % nodes), (int)(queries() % nodes), &settled);
+            total += settled;
+            ++ops;
+        });
+        cout << "{\"benchmark\": \"" << name << ".settled\", \"scale\": " << n
+             << ", \"settledPerQuery\": " << (double)total / ops << "}" << endl;
+    }
+
+    // Contraction hierarchy: the build is an offline step and takes seconds
+    // per 100k nodes, so larger scales are skipped
+    string name = "graph.pointToPoint.ch";
+    if (n > 100000 || (!config.filter.empty() && name.find(config.filter) == string::npos)) return;
+    graph.buildLandmarks(0);
+    ContractionHierarchy ch;
+    auto start = chrono::steady_clock::now();
+    graph.buildHierarchy(ch);
+    cout << "{\"benchmark\": \"graph.ch.build\", \"scale\": " << n
+         << ", \"ms\": " << chrono::duration<double, milli>(chrono::steady_clock::now() - start).count()
+         << ", \"shortcuts\": " << ch.shortcutCount() << "}" << endl;
+    graph.attachHierarchy(&ch);
+
+    mt19937 queries(99);
+    size_t settled = 0, total = 0, ops = 0;
+    runBench(name, n, 100000, [&](size_t) {
+        graph.findPath((int)(queries() % nodes), (int)(queries() % nodes), &settled);
+        total += settled;
+        ++ops;
+    });
+    cout << "{\"benchmark\": \"" << name << ".settled\", \"scale\": " << n
+         << ", \"settledPerQuery\": " << (double)total / ops << "}" << endl;
+    graph.attachHierarchy(nullptr);
+}
+
+void benchOrders(size_t n) {
+    mt19937 rng(7);
+    WarehouseGraph graph;
+    buildGrid(graph, 1024, rng);
+    graph.compile();
+
+    InventoryManager inv;
+    inv.addItem(101, "Laptop", 1 << 30, 17);
+    inv.addStock(101, 1000, 1 << 30);
+    ActionHistory history;
+    OrderManager om(&history);
+    vector<Order> orders;
+    orders.reserve(n);
+    for (size_t i = 0; i < n; ++i) orders.push_back(makeOrder((int)i + 1, rng, 1024));
+
+    runBench("orders.addOrder", n, n, [&](size_t i) {
+        om.addOrder(orders[i]);
+    });
+    // Top up in case the time budget cut the adds short
+    for (size_t i = om.pendingCount(); i < n; ++i) om.addOrder(orders[i]);
+
+    vector<int> ids;
+    for (const Order& o : orders) ids.push_back(o.id);
+    shuffle(ids.begin(), ids.end(), rng);
+    runBench("orders.removeOrder", n, n / 2, [&](size_t i) {
+        om.removeOrder(ids[i]);
+    });
+
+    runBench("orders.processNextOrder", n, om.pendingCount(), [&](size_t) {
+        om.processNextOrder(graph, inv);
+    });
+}
+
+void benchInventory(size_t n) {
+    mt19937 rng(11);
+    InventoryManager inv;
+    fillInventory(inv, n);
+
+    long long sink = 0;
+    runBench("inventory.lookup", n, 10000000, [&](size_t) {
+        Item* item = inv.getItem((int)(rng() % n));
+        sink += item ? item->quantity : 0;
+    });
+    runBench("inventory.lookupMiss", n, 10000000, [&](size_t) {
+        sink += inv.getItem((int)(n + rng() % n)) != nullptr;
+    });
+    runBench("inventory.updateStock", n, 10000000, [&](size_t i) {
+        inv.updateStock((int)(rng() % n), (i & 1) ? 1 : -1);
+    });
+    if (sink == 42) cerr << "";
+
+    InventoryManager shared(true);
+    fillInventory(shared, n);
+    runBench("inventory.tryReserve.threadSafe", n, 10000000, [&](size_t) {
+        shared.tryReserve((int)(rng() % n), 1);
+    });
+}
+
+void benchCatalog(size_t n) {
+    mt19937 rng(13);
+    vector<int> ids(n);
+    for (size_t i = 0; i < n; ++i) ids[i] = (int)i + 1;
+
+    {
+        ProductCatalog cat;
+        runBench("catalog.insert.sequential", n, n, [&](size_t i) {
+            cat.addProduct(ids[i], "Product", CATEGORIES[i % 6], 9.99);
+        });
+        for (size_t i = cat.size(); i < n; ++i) cat.addProduct(ids[i], "Product", CATEGORIES[i % 6], 9.99);
+
+        size_t found = 0;
+        runBench("catalog.findProduct", n, 10000000, [&](size_t) {
+            found += cat.findProduct((int)(rng() % n) + 1) != nullptr;
+        });
+        if (found == 0) cerr << "";
+    }
+
+    shuffle(ids.begin(), ids.end(), rng);
+    {
+        ProductCatalog cat;
+        runBench("catalog.insert.random", n, n, [&](size_t i) {
+            cat.addProduct(ids[i], "Product", CATEGORIES[i % 6], 9.99);
+        });
+    }
+}
+
+void benchStateJSON(size_t n) {
+    mt19937 rng(17);
+    WarehouseGraph graph;
+    InventoryManager inv;
+    ProductCatalog cat;
+    ActionHistory history;
+    OrderManager om(&history);
+
+    fillInventory(inv, n);
+    for (size_t i = 0; i < n; ++i) cat.addProduct((int)i, "Product " + to_string(i), CATEGORIES[i % 6], 9.99);
+    for (size_t i = 0; i < n; ++i) om.addOrder(makeOrder((int)i + 1, rng, 1024));
+
+    // No journal: nothing can be cached, every fragment is rendered each time
+    StateSerializer uncached;
+    runBench("json.state.uncached", n, 1000, [&](size_t) {
+        uncached.printState(inv, cat, om, 1);
+    });
+
+    ChangeJournal journal;
+    inv.setJournal(&journal);
+    StateSerializer serializer(&journal);
+    JsonWriter warm;
+    serializer.writeState(warm, inv, cat, om, 0, 50); // Fill the fragment cache
+    runBench("json.state", n, 1000, [&](size_t) {
+        serializer.printState(inv, cat, om, 1);
+    });
+    // What the dashboard asks for: first 50 pending rows
+    runBench("json.state.limit50", n, 1000, [&](size_t) {
+        serializer.printState(inv, cat, om, 1, 50);
+    });
+    // One stock change between polls: one fragment re-rendered, the rest copied
+    runBench("json.state.limit50.oneChange", n, 1000, [&](size_t i) {
+        inv.updateStock((int)(i % n), 0);
+        serializer.printState(inv, cat, om, 1, 50);
+    });
+}
+
+// --- Stress ---
+
+// Threads hammer a few hot SKUs with tryReserve and tryReserveAll (batches mix
+// SKUs, repeat one, or span two SKUs in the same shard) until demand far
+// exceeds stock, then check every unit is accounted for.
+bool stressHotSkus(size_t threads) {
+    const int HOT[] = {0, 1, 2, 64, 128}; // 0, 64 and 128 share a shard
+    const int HOT_COUNT = sizeof(HOT) / sizeof(HOT[0]);
+    const size_t OPS_PER_THREAD = 40000;
+    // Each SKU sees about 0.9 units of demand per op; half that in stock runs
+    // it dry midway, so both successful and refused reservations race
+    const int START_STOCK = (int)(threads * OPS_PER_THREAD / 2);
+
+    InventoryManager inv(true);
+    for (int id : HOT) inv.addItem(id, "Hot " + to_string(id), START_STOCK, id % 10);
+
+    // reservedBy[t][k]: units of HOT[k] thread t got; written only by thread t
+    vector<vector<long long>> reservedBy(threads, vector<long long>(HOT_COUNT, 0));
+    atomic<size_t> successes(0), failures(0);
+    atomic<bool> go(false);
+
+    vector<thread> pool;
+    for (size_t t = 0; t < threads; ++t) {
+        pool.emplace_back([&, t] {
+            mt19937 rng((unsigned int)(1000 + t));
+            vector<long long>& mine = reservedBy[t];
+            vector<pair<int, int>> lines;
+            vector<int> lineSku;
+            vector<Item> reserved;
+            size_t ok = 0, failed = 0;
+            while (!go.load()) this_thread::yield();
+
+            for (size_t i = 0; i < OPS_PER_THREAD; ++i) {
+                if (rng() % 2 == 0) {
+                    int k = (int)(rng() % HOT_COUNT);
+                    int qty = 1 + (int)(rng() % 3);
+                    Item after;
+                    if (inv.tryReserve(HOT[k], qty, &after)) {
+                        mine[k] += qty;
+                        ++ok;
+                    } else {
+                        ++failed;
+                    }
+                    continue;
+                }
+                lines.clear();
+                lineSku.clear();
+                int lineCount = 2 + (int)(rng() % 3);
+                for (int j = 0; j < lineCount; ++j) {
+                    int k = (int)(rng() % HOT_COUNT);
+                    lines.push_back({HOT[k], 1 + (int)(rng() % 3)});
+                    lineSku.push_back(k);
+                }
+                size_t failedLine = 0;
+                if (inv.tryReserveAll(lines, reserved, failedLine)) {
+                    for (size_t j = 0; j < lines.size(); ++j) mine[lineSku[j]] += lines[j].second;
+                    ++ok;
+                } else {
+                    ++failed;
+                }
+            }
+            successes += ok;
+            failures += failed;
+        });
+    }
+    auto start = chrono::steady_clock::now();
+    go = true;
+    for (thread& th : pool) th.join();
+    double elapsedMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    bool balanced = true;
+    for (int k = 0; k < HOT_COUNT; ++k) {
+        long long reserved = 0;
+        for (size_t t = 0; t < threads; ++t) reserved += reservedBy[t][k];
+        Item item;
+        inv.getItemCopy(HOT[k], item);
+        if (item.quantity < 0 || item.quantity + reserved != START_STOCK) {
+            cerr << "SKU " << HOT[k] << ": stock " << item.quantity << " + reserved " << reserved
+                 << " != " << START_STOCK << endl;
+            balanced = false;
+        }
+    }
+    cout << "{\"stress\": \"inventory.hotSku\", \"threads\": " << threads
+         << ", \"reservations\": " << successes.load()
+         << ", \"rejected\": " << failures.load()
+         << ", \"ms\": " << elapsedMs
+         << ", \"balanced\": " << (balanced ? "true" : "false") << "}" << endl;
+    return balanced;
+}
+
+int main(int argc, char* argv[]) {
+    bool stress = false;
+    size_t stressThreads = 16;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--stress") {
+            stress = true;
+        } else if (arg == "--threads" && i + 1 < argc) {
+            stressThreads = (size_t)max(1, atoi(argv[++i]));
+        } else if (arg == "--max-scale" && i + 1 < argc) {
+            config.maxScale = (size_t)atol(argv[++i]);
+        } else if (arg == "--budget-ms" && i + 1 < argc) {
+            config.budgetMs = atof(argv[++i]);
+        } else {
+            config.filter = arg;
+        }
+    }
+    if (stress) return stressHotSkus(stressThreads) ? 0 : 1;
+
+    for (size_t n = 1000; n <= config.maxScale; n *= 10) {
+        benchGraph(n);
+        benchRouting(n);
+        benchOrders(n);
+        benchInventory(n);
+        benchCatalog(n);
+        benchStateJSON(n);
+    }
+    return 0;
+}
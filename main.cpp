@@ -2,12 +2,33 @@
 #include <vector>
 #include <string>
 #include <sstream>
+#include <limits>
+#include <unordered_set>
+#include <mutex>
+#include <cstdlib>
+#include <fstream>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <shared_mutex>
+#include <csignal>
 #include "Order.h"
 #include "WarehouseGraph.h"
 #include "InventoryManager.h"
 #include "ProductCatalog.h"
 #include "ActionHistory.h"
+#include "ChangeJournal.h"
 #include "OrderManager.h"
+#include "OrderPipeline.h"
+#include "WriteAheadLog.h"
+#include "StateSnapshot.h"
+#include "DataLoader.h"
+#include "StateJSON.h"
+#include "StateSerializer.h"
+#include "StatePublisher.h"
+#include "LoadReplay.h"
+#include "HttpServer.h"
+#include "FramedProtocol.h"
 
 using namespace std;
 
@@ -24,6 +45,9 @@ void setupWarehouse(WarehouseGraph& graph) {
     graph.addEdge(6, 9, 3);
     graph.addEdge(3, 7, 2);
     graph.addEdge(8, 9, 1);
+
+    // Layout is fixed from here on: freeze it into the compact CSR form
+    graph.compile();
 }
 
 // Initialize inventory
@@ -46,63 +70,27 @@ void setupCatalog(ProductCatalog& catalog) {
 
 // --- API Mode Helpers ---
 
-void printStateJSON(InventoryManager& inv, ProductCatalog& cat, OrderManager& om, WarehouseGraph& graph) {
-    // Manually constructing JSON. In prod, use nlohmann/json.
-    cout << "{";
-    cout << "\"status\": \"success\",";
-    
-    // Serializing Pending Orders
-    cout << "\"pending\": [";
-    vector<Order> pending = om.getPendingOrders();
-    for(size_t i=0; i<pending.size(); ++i) {
-        cout << "{\"id\": " << pending[i].id 
-             << ", \"text\": \"Item: " << pending[i].itemName << " (Prio: " << pending[i].priority << ")\""
-             << ", \"prio\": " << pending[i].priority << "}";
-        if(i < pending.size() - 1) cout << ",";
-    }
-    cout << "],";
-
-    // Serializing Dispatched Orders
-    cout << "\"dispatched\": [";
-    vector<Order> dispatched = om.getDispatchedOrders();
-    for(size_t i=0; i<dispatched.size(); ++i) {
-        cout << "{\"id\": " << dispatched[i].id 
-             << ", \"text\": \"Item: " << dispatched[i].itemName << " (Sent)\"}";
-        if(i < dispatched.size() - 1) cout << ",";
-    }
-    cout << "],";
-
-    // Serializing Inventory (Hash Map)
-    cout << "\"inventory\": [";
-    vector<Item> items = inv.getInventory();
-    for(size_t i=0; i<items.size(); ++i) {
-        cout << "{\"id\": " << items[i].id 
-             << ", \"name\": \"" << items[i].name << "\""
-             << ", \"qty\": " << items[i].quantity 
-             << ", \"loc\": " << items[i].locationNode << "}";
-        if(i < items.size() - 1) cout << ",";
-    }
-    cout << "],";
-
-    // Serializing Catalog (BST)
-    cout << "\"catalog\": [";
-    vector<BSTNode> products = cat.getCatalog(); 
-    for(size_t i=0; i<products.size(); ++i) {
-        cout << "{\"id\": " << products[i].productId 
-             << ", \"name\": \"" << products[i].productName << "\""
-             << ", \"cat\": \"" << products[i].category << "\""
-             << ", \"price\": " << products[i].price << "}";
-        if(i < products.size() - 1) cout << ",";
-    }
-    cout << "]";
-    
-    cout << "}" << endl; // Use endl to flush
+// Rebuild a cancelled order from its history record
+bool restoreCancelledOrder(const ActionRecord& rec, OrderManager& om, InventoryManager& inv) {
+    Item item;
+    if (!inv.tryReserve(rec.itemId, rec.quantity, &item)) return false;
+
+    Order order;
+    order.id = rec.orderId;
+    order.priority = rec.priority;
+    order.itemId = rec.itemId;
+    order.itemName = item.name;
+    order.quantity = rec.quantity;
+    order.itemLocationNode = item.locationNode;
+
+    om.restoreOrder(order);
+    return true;
 }
 
 // --- Undo Helper ---
 void performUndo(ActionHistory& hist, OrderManager& om, InventoryManager& inv) {
     if (!hist.hasActions()) {
-        cout << "{\"status\":\"error\", \"msg\":\"Nothing to undo\"}" << endl;
+        apiOut() << "{\"status\":\"error\", \"msg\":\"Nothing to undo\"}" << endl;
         return;
     }
 
@@ -112,25 +100,51 @@ void performUndo(ActionHistory& hist, OrderManager& om, InventoryManager& inv) {
         // Reverse Add: Remove Order, Return Stock
         if (om.removeOrder(last.orderId)) {
             inv.updateStock(last.itemId, last.quantity); // Add back stock
-            cout << "{\"status\":\"success\", \"msg\":\"Undid ADD Order " << last.orderId << "\"}" << endl;
+            apiOut() << "{\"status\":\"success\", \"msg\":\"Undid ADD Order " << last.orderId << "\"}" << endl;
         } else {
-             cout << "{\"status\":\"error\", \"msg\":\"Order not found (already processed?)\"}" << endl;
+             apiOut() << "{\"status\":\"error\", \"msg\":\"Order not found (already processed?)\"}" << endl;
              // If order was processed, it's not in heap. The history stack should have had PROCESS_ORDER on top.
              // This implies proper stack discipline.
         }
     }
     else if (last.type == PROCESS_ORDER) {
         // Reverse Process: Move from Dispatch back to Pending (Heap)
-        if (om.revertProcess()) {
-            cout << "{\"status\":\"success\", \"msg\":\"Undid PROCESS (Returned to Queue)\"}" << endl;
+        if (om.revertProcess(inv)) {
+            apiOut() << "{\"status\":\"success\", \"msg\":\"Undid PROCESS (Returned to Queue)\"}" << endl;
         } else {
-            cout << "{\"status\":\"error\", \"msg\":\"Cannot undo process (Queue empty?)\"}" << endl;
+            apiOut() << "{\"status\":\"error\", \"msg\":\"Cannot undo process (Queue empty?)\"}" << endl;
         }
     }
     else if (last.type == DISPATCH_ORDER) {
         // Currently we don't store shipped items, so we can't easily undo dispatch 
         // unless we kept them. For this demo, we'll say it's irreversible or just log.
-        cout << "{\"status\":\"warning\", \"msg\":\"Cannot undo FINAL dispatch in this version\"}" << endl;
+        apiOut() << "{\"status\":\"warning\", \"msg\":\"Cannot undo FINAL dispatch in this version\"}" << endl;
+    }
+    else if (last.type == CANCEL_ORDER) {
+        if (restoreCancelledOrder(last, om, inv)) {
+            apiOut() << "{\"status\":\"success\", \"msg\":\"Undid CANCEL Order " << last.orderId << "\"}" << endl;
+        } else {
+            apiOut() << "{\"status\":\"error\", \"msg\":\"Cannot restore Order " << last.orderId << " (stock changed?)\"}" << endl;
+        }
+    }
+    else if (last.type == ADD_ORDER_BATCH) {
+        // Withdraw the batch's orders that are still pending and return their stock
+        int undone = 0;
+        for (int id = last.orderId; id < last.orderId + last.quantity; ++id) {
+            Order removed;
+            if (om.cancelOrder(id, &removed)) {
+                inv.updateStock(removed.itemId, removed.quantity);
+                ++undone;
+            }
+        }
+        apiOut() << "{\"status\":\"success\", \"msg\":\"Undid batch of " << undone << " orders\"}" << endl;
+    }
+    else if (last.type == REPRIORITIZE_ORDER) {
+        if (om.updatePriority(last.orderId, last.priority)) {
+            apiOut() << "{\"status\":\"success\", \"msg\":\"Restored priority of Order " << last.orderId << "\"}" << endl;
+        } else {
+            apiOut() << "{\"status\":\"error\", \"msg\":\"Order not pending anymore\"}" << endl;
+        }
     }
 }
 
@@ -152,7 +166,7 @@ void performUndoConsole(ActionHistory& hist, OrderManager& om, InventoryManager&
         }
     }
     else if (last.type == PROCESS_ORDER) {
-        if (om.revertProcess()) {
+        if (om.revertProcess(inv)) {
             cout << ">>> Undid PROCESS (Order returned to Pending Queue)\n";
         } else {
             cout << ">>> Error: Cannot undo process (Dispatch Queue empty?)\n";
@@ -161,89 +175,840 @@ void performUndoConsole(ActionHistory& hist, OrderManager& om, InventoryManager&
     else if (last.type == DISPATCH_ORDER) {
         cout << ">>> Cannot undo FINAL dispatch.\n";
     }
+    else if (last.type == CANCEL_ORDER) {
+        if (restoreCancelledOrder(last, om, inv)) {
+            cout << ">>> Undid CANCEL Order " << last.orderId << " (Order back in Pending Queue)\n";
+        } else {
+            cout << ">>> Error: Cannot restore Order " << last.orderId << " (Stock changed?)\n";
+        }
+    }
+    else if (last.type == REPRIORITIZE_ORDER) {
+        if (om.updatePriority(last.orderId, last.priority)) {
+            cout << ">>> Restored priority of Order " << last.orderId << "\n";
+        } else {
+            cout << ">>> Error: Order " << last.orderId << " is no longer pending\n";
+        }
+    }
 }
 
-// API Loops that listens for commands from Node.js
-void runApiMode(InventoryManager& inv, ProductCatalog& cat, OrderManager& om, WarehouseGraph& graph, ActionHistory& hist) {
+// --- Pipeline Mode Helpers ---
+
+// Routed orders collected on the pipeline's dispatch thread until the API thread takes them
+struct PipelineOutbox {
+    mutex lock;
+    vector<RoutedOrder> orders;
+};
+
+// One ADD_ORDER's arguments, as batched by ADD_ORDERS / BATCH_COMMIT
+struct OrderLine {
+    int itemId;
+    int quantity;
+    int priority;
+};
+
+// Everything an API command can touch
+struct ApiContext {
+    InventoryManager& inv;
+    ProductCatalog& cat;
+    OrderManager& om;
+    WarehouseGraph& graph;
+    ActionHistory& hist;
+    ChangeJournal& journal;
+    StateSerializer& serializer;
+    int orderCounter;
+
+    OrderPipeline* pipeline;  // Null unless started with --pipeline
+    PipelineOutbox* outbox;
+
+    // Persistence (--data-dir); wal is null when disabled or while replaying
+    WriteAheadLog* wal;
+    string snapshotPath;
+    size_t snapshotEvery;     // Snapshot + log reset after this many records (0 = never)
+
+    CommandRecorder* recorder = nullptr; // --record: every incoming line, timestamped
+    StatePublisher* publisher = nullptr;  // --http: read snapshots behind the state queries
+    LatencyStats* stats = nullptr;        // Null with --no-stats
+
+    // BATCH_BEGIN .. BATCH_COMMIT: ADD_ORDER lines held back until the commit.
+    // The batch belongs to the one command stream (stdin or --binary); --http
+    // serves many clients through this context, so it turns batches off.
+    bool batchesAllowed = true;
+    bool batchOpen = false;
+    vector<OrderLine> batchLines = {};
+};
+
+// Snapshot the current state, then start the WAL over: every record so far is covered
+bool takeSnapshot(ApiContext& ctx) {
+    if (!ctx.wal) return false;
+    ctx.wal->sync();
+    if (!saveSnapshot(ctx.snapshotPath, ctx.wal->lastLsn(), ctx.orderCounter, ctx.inv, ctx.cat, ctx.om, ctx.hist)) {
+        return false;
+    }
+    ctx.wal->reset(); // Safe now: the snapshot's rename has reached the disk
+    return true;
+}
+
+// Record a mutation that has just been applied
+void walAppend(ApiContext& ctx, WalOp op, const vector<int32_t>& args = {}) {
+    if (!ctx.wal) return;
+    ctx.wal->append(op, args);
+    if (ctx.snapshotEvery > 0 && ctx.wal->recordCount() >= ctx.snapshotEvery) takeSnapshot(ctx);
+}
+
+// PROCESS_PIPELINE: the API thread is the intake stage. It feeds the top-k orders
+// to the routing workers, waits for the batch, then moves results into OrderManager
+// (which stays single-threaded).
+void runPipelineBatch(int k, ApiContext& ctx) {
+    OrderPipeline& pipeline = *ctx.pipeline;
+    PipelineOutbox& outbox = *ctx.outbox;
+    OrderManager& om = ctx.om;
+    ActionHistory& hist = ctx.hist;
+    vector<Order> taken;
+    Order next;
+    while ((int)taken.size() < k && om.takeNextOrder(next)) taken.push_back(next);
+    if (taken.empty()) {
+        apiOut() << "{\"status\":\"error\", \"msg\":\"No orders to process\"}" << endl;
+        return;
+    }
+
+    // Bins are picked here, in ID order, so WAL replay can pick the same ones;
+    // the workers route to the chosen bin
+    int unreachable = 0;
+    vector<bool> assigned = om.assignBinsInIdOrder(taken, ctx.graph, ctx.inv);
+    for (size_t i = 0; i < taken.size(); ++i) {
+        if (assigned[i]) {
+            pipeline.submit(taken[i]);
+        } else {
+            om.restoreOrder(taken[i]);
+            ++unreachable;
+        }
+    }
+    pipeline.waitIdle();
+
+    vector<RoutedOrder> done;
+    {
+        lock_guard<mutex> lk(outbox.lock);
+        done.swap(outbox.orders);
+    }
+
+    int processed = 0;
+    vector<int32_t> processedIds;
+    for (RoutedOrder& r : done) {
+        if (r.distance != -1) {
+            om.acceptRouted(r.order);
+            hist.logAction({PROCESS_ORDER, r.order.id, 0, 0, 0});
+            processedIds.push_back(r.order.id);
+            ++processed;
+        } else {
+            om.returnPicks(r.order, ctx.inv);
+            om.restoreOrder(r.order); // Unreachable: back to pending, like processNextOrder
+            ++unreachable;
+        }
+    }
+    if (!processedIds.empty()) walAppend(ctx, WAL_PROCESS_IDS, processedIds);
+    apiOut() << "{\"status\":\"success\", \"msg\":\"Processed " << processed << " via pipeline\""
+         << ", \"processed\": " << processed << ", \"unreachable\": " << unreachable << "}" << endl;
+}
+
+void printPipelineStatsJSON(const OrderPipeline& pipeline) {
+    PipelineStats st = pipeline.stats();
+    apiOut() << "{\"status\": \"success\", \"workers\": " << pipeline.workerCount()
+         << ", \"intakeDepth\": " << st.intakeDepth
+         << ", \"dispatchDepth\": " << st.dispatchDepth
+         << ", \"submitted\": " << st.submitted
+         << ", \"routed\": " << st.routed
+         << ", \"dispatched\": " << st.dispatched
+         << ", \"intakeStalls\": " << st.intakeStalls
+         << ", \"routeStalls\": " << st.routeStalls << "}" << endl;
+}
+
+// Resident set size in KB from /proc (Linux); -1 where unavailable
+long residentKB() {
+    ifstream status("/proc/self/status");
     string line;
-    int orderCounter = 1;
-    
-    // Output initial ready signal
-    cout << "{\"status\":\"ready\"}" << endl;
+    while (getline(status, line)) {
+        if (line.compare(0, 6, "VmRSS:") == 0) return atol(line.c_str() + 6);
+    }
+    return -1;
+}
 
-    while (getline(cin, line)) {
-        stringstream ss(line);
-        string cmd;
-        ss >> cmd;
+// MEMORY: undo history footprint plus process RSS
+void printMemoryJSON(ActionHistory& hist) {
+    apiOut() << "{\"status\": \"success\", \"rssKB\": " << residentKB()
+         << ", \"history\": {\"depth\": " << hist.size()
+         << ", \"maxDepth\": " << hist.getMaxDepth()
+         << ", \"hot\": " << hist.hotCount()
+         << ", \"hotCapacity\": " << hist.hotCapacity()
+         << ", \"hotBytes\": " << hist.hotBytes()
+         << ", \"spilled\": " << hist.spilledCount()
+         << ", \"spillFileBytes\": " << hist.spillFileBytes()
+         << ", \"spillBatches\": " << hist.spillBatchCount()
+         << ", \"pageIns\": " << hist.pageInCount()
+         << ", \"dropped\": " << hist.droppedCount() << "}}" << endl;
+}
+
+// Run one API command line, writing its JSON response to apiOut()
+// ADD_ORDERS / BATCH_COMMIT: every line is checked against stock first and
+// either all orders are placed or none. Stock comes off in one pass, the heap
+// takes the orders in one bulk insert, and UNDO reverts the batch as a whole.
+void placeOrderBatch(const vector<OrderLine>& lines, ApiContext& ctx) {
+    if (lines.empty()) {
+        apiOut() << "{\"status\":\"error\", \"msg\":\"Empty batch\"}" << endl;
+        return;
+    }
+    vector<pair<int, int>> wanted;
+    wanted.reserve(lines.size());
+    for (const OrderLine& l : lines) wanted.push_back({l.itemId, l.quantity});
+
+    vector<Item> reserved;
+    size_t failed = 0;
+    if (!ctx.inv.tryReserveAll(wanted, reserved, failed)) {
+        apiOut() << "{\"status\":\"error\", \"msg\":\"Invalid item or stock\", \"line\": " << failed
+                 << ", \"itemId\": " << lines[failed].itemId << "}" << endl;
+        return;
+    }
+
+    int firstId = ctx.orderCounter;
+    vector<Order> orders(lines.size());
+    vector<int32_t> walArgs;
+    walArgs.reserve(lines.size() * 3);
+    for (size_t i = 0; i < lines.size(); ++i) {
+        Order& o = orders[i];
+        o.id = ctx.orderCounter++;
+        o.itemId = lines[i].itemId;
+        o.itemName = reserved[i].name;
+        o.itemLocationNode = reserved[i].locationNode;
+        o.quantity = lines[i].quantity;
+        o.priority = lines[i].priority;
+        walArgs.insert(walArgs.end(), {lines[i].itemId, lines[i].quantity, lines[i].priority});
+    }
+    ctx.om.addOrders(orders);
+    ctx.hist.logAction({ADD_ORDER_BATCH, firstId, 0, (int)orders.size(), 0});
+    walAppend(ctx, WAL_ADD_ORDERS, walArgs);
+
+    apiOut() << "{\"status\":\"success\", \"msg\":\"Placed " << orders.size() << " orders\", \"firstId\": "
+             << firstId << ", \"count\": " << orders.size() << "}" << endl;
+}
+
+void handleCommand(const string& line, ApiContext& ctx) {
+    InventoryManager& inv = ctx.inv;
+    ProductCatalog& cat = ctx.cat;
+    OrderManager& om = ctx.om;
+    WarehouseGraph& graph = ctx.graph;
+    ActionHistory& hist = ctx.hist;
+    ChangeJournal& journal = ctx.journal;
 
+    stringstream ss(line);
+    string cmd;
+    ss >> cmd;
+
+    if (ctx.batchOpen) {
         if (cmd == "ADD_ORDER") {
-            int id, qty, prio;
-            ss >> id >> qty >> prio;
-            Item* item = inv.getItem(id);
-            if (item && inv.hasStock(id, qty)) {
-                Order newOrder;
-                newOrder.id = orderCounter++;
-                newOrder.itemName = item->name;
-                newOrder.itemLocationNode = item->locationNode;
-                newOrder.quantity = qty;
-                newOrder.priority = prio;
-                
-                // 1. Log Action BEFORE adding (or after, just ensure data is there)
-                hist.logAction({ADD_ORDER, newOrder.id, id, qty, prio});
-                
-                // 2. Perform Ops
-                om.addOrder(newOrder); // Note: remove internal logging in OrderManager if duplicate
-                inv.updateStock(id, -qty);
-                
-                cout << "{\"status\":\"success\", \"msg\":\"Order placed\"}" << endl;
+            OrderLine l;
+            if (ss >> l.itemId >> l.quantity >> l.priority) {
+                ctx.batchLines.push_back(l);
+                apiOut() << "{\"status\":\"queued\", \"line\": " << ctx.batchLines.size() - 1 << "}" << endl;
             } else {
-                cout << "{\"status\":\"error\", \"msg\":\"Invalid item or stock\"}" << endl;
+                apiOut() << "{\"status\":\"error\", \"msg\":\"Usage: ADD_ORDER <itemId> <qty> <priority>\"}" << endl;
             }
+            return;
+        }
+        if (cmd == "BATCH_COMMIT" || cmd == "BATCH_ABORT") {
+            vector<OrderLine> lines;
+            lines.swap(ctx.batchLines);
+            ctx.batchOpen = false;
+            if (cmd == "BATCH_COMMIT") placeOrderBatch(lines, ctx);
+            else apiOut() << "{\"status\":\"success\", \"msg\":\"Batch discarded\"}" << endl;
+            return;
+        }
+        if (cmd != "BATCH_BEGIN") {
+            apiOut() << "{\"status\":\"error\", \"msg\":\"Only ADD_ORDER, BATCH_COMMIT or BATCH_ABORT inside a batch\"}" << endl;
+            return;
+        }
+    }
+
+    if (cmd == "BATCH_BEGIN") {
+        if (!ctx.batchesAllowed) {
+            apiOut() << "{\"status\":\"error\", \"msg\":\"Batches need a single command stream; use ADD_ORDERS\"}" << endl;
+        } else if (ctx.batchOpen) {
+            apiOut() << "{\"status\":\"error\", \"msg\":\"Batch already open\"}" << endl;
+        } else {
+            ctx.batchOpen = true;
+            apiOut() << "{\"status\":\"success\", \"msg\":\"Batch open\"}" << endl;
         }
-        else if (cmd == "PROCESS") {
-             // Check if there is anything to process first?
-             // Since processNextOrder is void/cout, we should probably check size or add a check
-             // But let's just run it. 
-             // Ideally we should peek the top order to log its ID for undo tracking.
-             // OrderManager::processNextOrder handles logic. We need it to return info or we log "Last Processed"
-             // For simplicity, let's just log a generic PROCESS action. But strict undo needs ID.
-             // Let's modify processNextOrder? Or assume stack order implies correct reverse.
-             // If we rely on stack order: "Undo Process" simply assumes the last thing in Dispatch Queue is what we revert.
-             
-             // We need to know if it SUCCEEDED.
-             vector<Order> pending = om.getPendingOrders();
-             if (!pending.empty()) {
-                 hist.logAction({PROCESS_ORDER, pending[0].id, 0, 0, 0}); // Log BEFORE? No, what if fail?
-                 // Actually processNextOrder moves it.
-                 // Correct logic: successful process -> Log.
-                 // But ProcessNextOrder inside OrderManager logs to console.
-                 // Let's rely on simple stack: If Process is called and succeeds, we track it.
-                 
-                 om.processNextOrder(graph);
-                 // We assume success if pending wasn't empty. 
-                 
-                 cout << "{\"status\":\"success\", \"msg\":\"Processed\"}" << endl;
+    }
+    else if (cmd == "BATCH_COMMIT" || cmd == "BATCH_ABORT") {
+        apiOut() << "{\"status\":\"error\", \"msg\":\"No batch open\"}" << endl;
+    }
+    else if (cmd == "ADD_ORDERS") {
+        // ADD_ORDERS <itemId> <qty> <prio> [; <itemId> <qty> <prio> ...]
+        string rest;
+        getline(ss, rest);
+        for (char& c : rest) {
+            if (c == ';' || c == ',') c = ' ';
+        }
+        stringstream args(rest);
+        vector<OrderLine> lines;
+        OrderLine l;
+        while (args >> l.itemId >> l.quantity >> l.priority) lines.push_back(l);
+        args.clear();
+        string leftover;
+        if (args >> leftover) {
+            apiOut() << "{\"status\":\"error\", \"msg\":\"Usage: ADD_ORDERS <itemId> <qty> <priority> [; ...]\"}" << endl;
+        } else {
+            placeOrderBatch(lines, ctx);
+        }
+    }
+    else if (cmd == "ADD_ORDER") {
+        int id = 0, qty = 0, prio = 0;
+        ss >> id >> qty >> prio;
+        // Stock check and deduction in a single probe
+        Item item;
+        if (qty <= 0) {
+            apiOut() << "{\"status\":\"error\", \"msg\":\"Quantity must be positive\"}" << endl;
+        } else if (inv.tryReserve(id, qty, &item)) {
+            Order newOrder;
+            newOrder.id = ctx.orderCounter++;
+            newOrder.itemId = id;
+            newOrder.itemName = item.name;
+            newOrder.itemLocationNode = item.locationNode;
+            newOrder.quantity = qty;
+            newOrder.priority = prio;
+            
+            // 1. Log Action BEFORE adding (or after, just ensure data is there)
+            hist.logAction({ADD_ORDER, newOrder.id, id, qty, prio});
+            
+            // 2. Perform Ops (stock was already deducted by tryReserve)
+            om.addOrder(newOrder);
+            walAppend(ctx, WAL_ADD_ORDER, {id, qty, prio});
+            
+            apiOut() << "{\"status\":\"success\", \"msg\":\"Order placed\"}" << endl;
+        } else {
+            apiOut() << "{\"status\":\"error\", \"msg\":\"Invalid item or stock\"}" << endl;
+        }
+    }
+    else if (cmd == "PROCESS") {
+         // Logged only once it succeeded: UNDO reverts the back of the dispatch queue
+         const Order* next = om.peekTop();
+         if (!next) {
+             apiOut() << "{\"status\":\"error\", \"msg\":\"No orders to process\"}" << endl;
+         } else {
+             int id = next->id;
+             if (om.processNextOrder(graph, inv)) {
+                 hist.logAction({PROCESS_ORDER, id, 0, 0, 0});
+                 walAppend(ctx, WAL_PROCESS);
+                 apiOut() << "{\"status\":\"success\", \"msg\":\"Processed\"}" << endl;
              } else {
-                 cout << "{\"status\":\"error\", \"msg\":\"No orders to process\"}" << endl;
+                 apiOut() << "{\"status\":\"error\", \"msg\":\"No reachable bin with enough stock\"}" << endl;
              }
+         }
+    }
+    else if (cmd == "PROCESS_WAVE") {
+        int k = 10, budgetMs = 20;
+        ss >> k >> budgetMs;
+        WaveResult wave = om.processWave(graph, inv, k, budgetMs);
+        if (wave.orders.empty()) {
+            apiOut() << "{\"status\":\"error\", \"msg\":\"No orders to process\"}" << endl;
+        } else {
+            // One PROCESS record per order so UNDO reverts them one by one.
+            // The WAL gets the resulting order, not the call: tour planning is time-boxed.
+            vector<int32_t> waveIds;
+            for (const Order& o : wave.orders) {
+                hist.logAction({PROCESS_ORDER, o.id, 0, 0, 0});
+                waveIds.push_back(o.id);
+            }
+            walAppend(ctx, WAL_PROCESS_IDS, waveIds);
+            apiOut() << "{\"status\":\"success\", \"msg\":\"Processed wave of " << wave.orders.size() << "\""
+                 << ", \"orders\": [";
+            for (size_t i = 0; i < wave.orders.size(); ++i) {
+                apiOut() << wave.orders[i].id;
+                if (i < wave.orders.size() - 1) apiOut() << ",";
+            }
+            apiOut() << "], \"tour\": [";
+            for (size_t i = 0; i < wave.tour.size(); ++i) {
+                apiOut() << wave.tour[i];
+                if (i < wave.tour.size() - 1) apiOut() << ",";
+            }
+            apiOut() << "], \"tourDistance\": " << wave.tourDistance
+                 << ", \"individualDistance\": " << wave.individualDistance << "}" << endl;
         }
-        else if (cmd == "DISPATCH") {
-            om.dispatchNextOrder();
-            // hist.logAction({DISPATCH_ORDER...}); 
-            cout << "{\"status\":\"success\", \"msg\":\"Dispatched\"}" << endl;
+    }
+    else if (cmd == "CANCEL_ORDER") {
+        int orderId;
+        ss >> orderId;
+        Order cancelled;
+        if (om.cancelOrder(orderId, &cancelled)) {
+            inv.updateStock(cancelled.itemId, cancelled.quantity); // Return stock
+            hist.logAction({CANCEL_ORDER, cancelled.id, cancelled.itemId, cancelled.quantity, cancelled.priority});
+            walAppend(ctx, WAL_CANCEL_ORDER, {orderId});
+            apiOut() << "{\"status\":\"success\", \"msg\":\"Order " << orderId << " cancelled\"}" << endl;
+        } else {
+            apiOut() << "{\"status\":\"error\", \"msg\":\"Order not pending\"}" << endl;
         }
-        else if (cmd == "UNDO") {
-            performUndo(hist, om, inv);
+    }
+    else if (cmd == "UPDATE_PRIORITY") {
+        int orderId, prio;
+        ss >> orderId >> prio;
+        const Order* pendingOrder = om.findPendingOrder(orderId);
+        if (pendingOrder) {
+            hist.logAction({REPRIORITIZE_ORDER, orderId, pendingOrder->itemId, pendingOrder->quantity, pendingOrder->priority});
+            om.updatePriority(orderId, prio);
+            walAppend(ctx, WAL_UPDATE_PRIORITY, {orderId, prio});
+            apiOut() << "{\"status\":\"success\", \"msg\":\"Order " << orderId << " priority set to " << prio << "\"}" << endl;
+        } else {
+            apiOut() << "{\"status\":\"error\", \"msg\":\"Order not pending\"}" << endl;
+        }
+    }
+    else if (cmd == "ADD_STOCK") {
+        int itemId, node, qty;
+        if (ss >> itemId >> node >> qty && qty > 0 && inv.addStock(itemId, node, qty)) {
+            walAppend(ctx, WAL_ADD_STOCK, {itemId, node, qty});
+            apiOut() << "{\"status\":\"success\", \"msg\":\"Stocked " << qty << " of item " << itemId << " at node " << node << "\"}" << endl;
+        } else {
+            apiOut() << "{\"status\":\"error\", \"msg\":\"Unknown item or bad quantity\"}" << endl;
         }
-        else if (cmd == "GET_STATE") {
-            printStateJSON(inv, cat, om, graph);
+    }
+    else if (cmd == "STATS" || cmd == "STATS_RESET") {
+        if (!ctx.stats) {
+            apiOut() << "{\"status\":\"error\", \"msg\":\"Stats disabled (started with --no-stats)\"}" << endl;
+        } else if (cmd == "STATS") {
+            ctx.stats->printJSON(apiOut());
+        } else {
+            ctx.stats->reset();
+            apiOut() << "{\"status\":\"success\", \"msg\":\"Stats reset\"}" << endl;
         }
-        else {
-             cout << "{\"status\":\"error\", \"msg\":\"Unknown command\"}" << endl;
+    }
+    else if (cmd == "MEMORY") {
+        printMemoryJSON(hist);
+    }
+    else if (cmd == "PROCESS_PIPELINE" || cmd == "PIPELINE_STATS") {
+        if (!ctx.pipeline) {
+            apiOut() << "{\"status\":\"error\", \"msg\":\"Pipeline mode not enabled (start with --pipeline)\"}" << endl;
+        } else if (cmd == "PIPELINE_STATS") {
+            printPipelineStatsJSON(*ctx.pipeline);
+        } else {
+            int k = 1;
+            ss >> k;
+            runPipelineBatch(k, ctx);
         }
     }
+    else if (cmd == "DISPATCH") {
+        om.dispatchNextOrder();
+        walAppend(ctx, WAL_DISPATCH);
+        // hist.logAction({DISPATCH_ORDER...}); 
+        apiOut() << "{\"status\":\"success\", \"msg\":\"Dispatched\"}" << endl;
+    }
+    else if (cmd == "UNDO") {
+        performUndo(hist, om, inv);
+        walAppend(ctx, WAL_UNDO);
+    }
+    else if (cmd == "SNAPSHOT") {
+        if (!ctx.wal) {
+            apiOut() << "{\"status\":\"error\", \"msg\":\"Persistence not enabled (start with --data-dir)\"}" << endl;
+        } else if (takeSnapshot(ctx)) {
+            apiOut() << "{\"status\":\"success\", \"msg\":\"Snapshot written\"}" << endl;
+        } else {
+            apiOut() << "{\"status\":\"error\", \"msg\":\"Snapshot failed\"}" << endl;
+        }
+    }
+    else if (cmd == "GET_STATE") {
+        SpanTimer timer(ctx.stats, SPAN_JSON);
+        size_t limit;
+        if (ss >> limit) ctx.serializer.printState(inv, cat, om, journal.currentVersion(), limit);
+        else ctx.serializer.printState(inv, cat, om, journal.currentVersion());
+    }
+    else if (cmd == "GET_PRODUCTS_RANGE" || cmd == "GET_CATEGORY") {
+        vector<const BSTNode*> products;
+        if (cmd == "GET_PRODUCTS_RANGE") {
+            int lo = 0, hi = -1;
+            ss >> lo >> hi;
+            products = cat.rangeById(lo, hi);
+        } else {
+            string category;
+            getline(ss >> ws, category); // Category names may contain spaces
+            products = cat.productsInCategory(category);
+        }
+        SpanTimer timer(ctx.stats, SPAN_JSON);
+        JsonWriter& w = responseWriter();
+        w.raw("{\"status\": \"success\", \"catalog\": [");
+        for (size_t i = 0; i < products.size(); ++i) {
+            if (i) w.raw(',');
+            writeProductJSON(w, *products[i]);
+        }
+        w.raw("]}");
+        sendResponse(w);
+    }
+    else if (cmd == "GET_STATE_SINCE") {
+        // GET_STATE_SINCE <version> <epoch>, both from an earlier state response
+        long long since = 0, epoch = -1;
+        ss >> since >> epoch;
+        SpanTimer timer(ctx.stats, SPAN_JSON);
+        ctx.serializer.printDelta(inv, cat, om, journal, since, epoch);
+    }
+    else if (cmd == "ROUTE") {
+        // Point-to-point path between any two nodes (picker -> bin). With COMPARE
+        // the plain Dijkstra search also runs, to show what the landmarks save.
+        int from, to;
+        string option;
+        if (!(ss >> from >> to)) {
+            apiOut() << "{\"status\":\"error\", \"msg\":\"Usage: ROUTE <from> <to> [COMPARE]\"}" << endl;
+            return;
+        }
+        ss >> option;
+        size_t settled = 0;
+        pair<int, vector<int>> route = graph.findPath(from, to, &settled);
+        apiOut() << "{\"status\": \"success\", \"distance\": " << route.first << ", \"path\": [";
+        for (size_t i = 0; i < route.second.size(); ++i) apiOut() << (i ? "," : "") << route.second[i];
+        apiOut() << "], \"mode\": \"" << graph.routingMode() << "\", \"settled\": " << settled;
+        if (option == "COMPARE") {
+            size_t dijkstraSettled = 0;
+            graph.findPathDijkstra(from, to, &dijkstraSettled);
+            apiOut() << ", \"dijkstraSettled\": " << dijkstraSettled;
+        }
+        apiOut() << "}" << endl;
+    }
+    else if (cmd == "GET_PENDING") {
+        size_t offset = 0, limit = 50;
+        ss >> offset >> limit;
+        SpanTimer timer(ctx.stats, SPAN_JSON);
+        JsonWriter& w = responseWriter();
+        w.raw("{\"status\": \"success\", \"total\": ").integer((long long)om.pendingCount())
+         .raw(", \"offset\": ").integer((long long)offset).raw(',');
+        writePendingJSON(w, om.getPendingOrders(offset, limit));
+        w.raw('}');
+        sendResponse(w);
+    }
+    else {
+         apiOut() << "{\"status\":\"error\", \"msg\":\"Unknown command\"}" << endl;
+    }
 }
 
+// A command handler, timed into the per-command histogram when stats are on
+template <typename Handler>
+void runTimed(const string& line, ApiContext& ctx, Handler handle) {
+    if (!ctx.stats) {
+        handle(line, ctx);
+        return;
+    }
+    auto start = chrono::steady_clock::now();
+    handle(line, ctx);
+    auto ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+
+    size_t from = line.find_first_not_of(" \t");
+    string name = from == string::npos ? "" : line.substr(from, line.find_first_of(" \t", from) - from);
+    ctx.stats->recordCommand(name, (uint64_t)ns);
+}
+
+void runCommand(const string& line, ApiContext& ctx) {
+    runTimed(line, ctx, handleCommand);
+}
+
+// Output sink for replay: responses of re-applied commands are discarded
+class NullBuffer : public streambuf {
+protected:
+    int overflow(int c) override { return c; }
+};
+
+// Re-apply logged mutations newer than the snapshot, through the same command
+// handlers that produced them (ordering is deterministic, see Order::operator<)
+size_t replayWal(ApiContext& ctx, const vector<WalRecord>& records, uint64_t afterLsn) {
+    NullBuffer sink;
+    streambuf* saved = cout.rdbuf(&sink);
+    WriteAheadLog* wal = ctx.wal;
+    ctx.wal = nullptr; // Don't log the replay itself
+
+    size_t applied = 0;
+    for (const WalRecord& rec : records) {
+        if (rec.lsn <= afterLsn) continue;
+        const vector<int32_t>& a = rec.args;
+        switch (rec.op) {
+            case WAL_ADD_ORDER:
+                if (a.size() == 3) handleCommand("ADD_ORDER " + to_string(a[0]) + " " + to_string(a[1]) + " " + to_string(a[2]), ctx);
+                break;
+            case WAL_PROCESS: handleCommand("PROCESS", ctx); break;
+            case WAL_DISPATCH: handleCommand("DISPATCH", ctx); break;
+            case WAL_UNDO: handleCommand("UNDO", ctx); break;
+            case WAL_CANCEL_ORDER:
+                if (a.size() == 1) handleCommand("CANCEL_ORDER " + to_string(a[0]), ctx);
+                break;
+            case WAL_UPDATE_PRIORITY:
+                if (a.size() == 2) handleCommand("UPDATE_PRIORITY " + to_string(a[0]) + " " + to_string(a[1]), ctx);
+                break;
+            case WAL_PROCESS_IDS:
+                for (int orderId : ctx.om.moveToDispatch(vector<int>(a.begin(), a.end()), ctx.graph, ctx.inv)) {
+                    ctx.hist.logAction({PROCESS_ORDER, orderId, 0, 0, 0});
+                }
+                break;
+            case WAL_ADD_STOCK:
+                if (a.size() == 3) handleCommand("ADD_STOCK " + to_string(a[0]) + " " + to_string(a[1]) + " " + to_string(a[2]), ctx);
+                break;
+            case WAL_ADD_ORDERS: {
+                vector<OrderLine> lines;
+                for (size_t i = 0; i + 2 < a.size(); i += 3) lines.push_back({a[i], a[i + 1], a[i + 2]});
+                placeOrderBatch(lines, ctx);
+                break;
+            }
+        }
+        ++applied;
+    }
+
+    ctx.wal = wal;
+    cout.rdbuf(saved);
+    return applied;
+}
+
+// API Loops that listens for commands from Node.js
+void runApiMode(ApiContext& ctx, const string& readyExtra) {
+    string line;
+    
+    // Output initial ready signal
+    cout << "{\"status\":\"ready\"" << readyExtra << "}" << endl;
+
+    while (getline(cin, line)) {
+        if (ctx.recorder) ctx.recorder->record(line);
+        runCommand(line, ctx);
+    }
+
+    // Clean shutdown: leave a fresh snapshot so the next start replays nothing
+    if (ctx.wal) takeSnapshot(ctx);
+}
+
+// --api --binary: the same commands in length-prefixed frames (FramedProtocol.h),
+// so the client can pipeline. Every frame that has arrived is run back to back
+// and the batch of responses leaves in one write.
+void runBinaryApiMode(ApiContext& ctx, const string& readyExtra) {
+    FrameReader in(0);
+    FrameWriter out;
+    // Stray console output (order processing logs) must not land inside the frames
+    streambuf* console = cout.rdbuf(cerr.rdbuf());
+    apiOutSlot() = &out.stream();
+
+    out.writeFrame(0, "{\"status\":\"ready\", \"protocol\":\"binary\"" + readyExtra + "}");
+    bool open = out.flushTo(1);
+
+    uint32_t id;
+    string line;
+    bool oversized;
+    while (open && in.fill()) {
+        while (in.next(id, line, oversized)) {
+            out.beginFrame(id);
+            if (oversized) {
+                out.stream() << "{\"status\":\"error\", \"msg\":\"Command too long\"}";
+            } else {
+                if (ctx.recorder) ctx.recorder->record(line);
+                runCommand(line, ctx);
+            }
+            out.endFrame();
+        }
+        open = out.flushTo(1);
+    }
+
+    apiOutSlot() = &cout;
+    cout.rdbuf(console);
+    if (ctx.wal) takeSnapshot(ctx);
+}
+
+// Load test: run a recorded or synthetic stream through the API handlers,
+// discarding responses, and print one throughput/latency report
+void runReplayMode(ApiContext& ctx, const vector<RecordedCommand>& stream, double speed) {
+    NullBuffer sink;
+    streambuf* saved = cout.rdbuf(&sink);
+    ReplayReport report = replayCommands(stream, speed, [&ctx](const string& line) {
+        runCommand(line, ctx);
+    });
+    cout.rdbuf(saved);
+
+    printReplayReportJSON(report, cout);
+    if (ctx.wal) takeSnapshot(ctx);
+}
+
+#ifdef __linux__
+// Commands that only read engine state: HTTP mode runs these side by side
+bool isReadOnlyCommand(const string& line) {
+    static const unordered_set<string> readOnly = {
+        "GET_STATE", "GET_STATE_SINCE", "GET_PENDING", "GET_PRODUCTS_RANGE", "GET_CATEGORY",
+        "STATS", "MEMORY", "ROUTE", "PIPELINE_STATS"};
+    stringstream ss(line);
+    string cmd;
+    ss >> cmd;
+    return readOnly.count(cmd) > 0;
+}
+
+// Dashboard queries answered from the published snapshot, with no engine lock
+bool isSnapshotCommand(const string& line) {
+    stringstream ss(line);
+    string cmd;
+    ss >> cmd;
+    return cmd == "GET_STATE" || cmd == "GET_STATE_SINCE" || cmd == "GET_PENDING";
+}
+
+// GET_STATE / GET_STATE_SINCE / GET_PENDING against the latest published view.
+// Same arguments and JSON as in handleCommand.
+void handleSnapshotCommand(const string& line, ApiContext& ctx) {
+    stringstream ss(line);
+    string cmd;
+    ss >> cmd;
+    shared_ptr<const StateView> view = ctx.publisher->view();
+
+    SpanTimer timer(ctx.stats, SPAN_JSON);
+    JsonWriter& w = responseWriter();
+    if (cmd == "GET_STATE") {
+        size_t limit;
+        if (ss >> limit) StatePublisher::writeState(w, *view, limit);
+        else StatePublisher::writeState(w, *view);
+    } else if (cmd == "GET_STATE_SINCE") {
+        long long since = 0, epoch = -1;
+        ss >> since >> epoch;
+        StatePublisher::writeDelta(w, *view, ctx.journal, since, epoch);
+    } else {
+        size_t offset = 0, limit = 50;
+        ss >> offset >> limit;
+        StatePublisher::writePending(w, *view, offset, limit);
+    }
+    sendResponse(w);
+}
+
+// String value of "key" in a flat JSON object such as {"command": "ADD_ORDER 101 1 5"}
+bool jsonStringField(const string& body, const string& key, string& out) {
+    size_t pos = body.find("\"" + key + "\"");
+    if (pos == string::npos) return false;
+    pos = body.find_first_not_of(" \t\r\n", pos + key.size() + 2);
+    if (pos == string::npos || body[pos] != ':') return false;
+    pos = body.find_first_not_of(" \t\r\n", pos + 1);
+    if (pos == string::npos || body[pos] != '"') return false;
+
+    out.clear();
+    for (++pos; pos < body.size(); ++pos) {
+        char c = body[pos];
+        if (c == '"') return true;
+        if (c != '\\') {
+            out += c;
+            continue;
+        }
+        if (++pos >= body.size()) return false;
+        switch (body[pos]) {
+            case 'n': out += '\n'; break;
+            case 't': out += '\t'; break;
+            case 'r': out += '\r'; break;
+            case 'u': {
+                // Commands are ASCII; anything wider is rejected
+                if (pos + 4 >= body.size()) return false;
+                unsigned long code = strtoul(body.substr(pos + 1, 4).c_str(), nullptr, 16);
+                if (code == 0 || code > 0x7f) return false;
+                out += (char)code;
+                pos += 4;
+                break;
+            }
+            default: out += body[pos]; break; // \" \\ \/
+        }
+    }
+    return false;
+}
+
+// Digits only, like the Node front end's parseInt + isInteger + >= 0 check
+bool isCount(const string& s) {
+    return !s.empty() && s.size() < 19 && s.find_first_not_of("0123456789") == string::npos;
+}
+
+HttpServer* activeHttpServer = nullptr;
+
+void stopHttpServer(int) {
+    if (activeHttpServer) activeHttpServer->stop();
+}
+
+// --http: serve the Node front end's API directly. POST /api/command takes
+// {"command": "..."}, GET /api/state[?since=V&epoch=E|?limit=N] maps to GET_STATE /
+// GET_STATE_SINCE, and with --http-static the dashboard files are served too.
+// Every mutating command runs alone and then publishes a new read snapshot;
+// the state queries read the latest snapshot without touching the engine,
+// and the other read-only commands share it.
+void runHttpMode(ApiContext& ctx, const string& host, int port, size_t workers, const string& staticDir,
+                 const string& readyExtra) {
+    shared_mutex engineLock;
+    StatePublisher publisher(ctx.journal);
+    publisher.publish(ctx.inv, ctx.cat, ctx.om);
+    ctx.publisher = &publisher;
+    ctx.batchesAllowed = false; // One shared context for every client: ADD_ORDERS instead
+
+    auto execute = [&ctx, &engineLock, &publisher](const string& line) {
+        ostringstream out;
+        apiOutSlot() = &out;
+        if (isSnapshotCommand(line)) {
+            runTimed(line, ctx, handleSnapshotCommand);
+        } else if (isReadOnlyCommand(line)) {
+            shared_lock<shared_mutex> lk(engineLock);
+            runCommand(line, ctx);
+        } else {
+            unique_lock<shared_mutex> lk(engineLock);
+            if (ctx.recorder) ctx.recorder->record(line);
+            runCommand(line, ctx);
+            publisher.publish(ctx.inv, ctx.cat, ctx.om);
+        }
+        apiOutSlot() = &cout;
+
+        string body = out.str();
+        while (!body.empty() && body.back() == '\n') body.pop_back();
+        return body.empty() ? string("{}") : body;
+    };
+
+    HttpServer server([&](const HttpRequest& req, HttpResponse& resp) {
+        if (req.path == "/api/command") {
+            string command;
+            if (req.method != "POST") {
+                resp.status = 405;
+                resp.body = "{\"status\":\"error\", \"msg\":\"Use POST\"}";
+            } else if (!jsonStringField(req.body, "command", command)) {
+                resp.status = 400;
+                resp.body = "{\"status\":\"error\", \"msg\":\"Expected {\\\"command\\\": \\\"...\\\"}\"}";
+            } else {
+                resp.body = execute(command);
+            }
+        } else if (req.path == "/api/state") {
+            string since = req.queryParam("since"), epoch = req.queryParam("epoch"), limit = req.queryParam("limit");
+            string command = "GET_STATE";
+            if (isCount(since)) command = "GET_STATE_SINCE " + since + (isCount(epoch) ? " " + epoch : "");
+            else if (isCount(limit)) command = "GET_STATE " + limit;
+            resp.body = execute(command);
+        } else if (!staticDir.empty() && req.method == "GET") {
+            static const map<string, pair<string, string>> files = {
+                {"/", {"index.html", "text/html"}},
+                {"/index.html", {"index.html", "text/html"}},
+                {"/script.js", {"script.js", "application/javascript"}},
+                {"/style.css", {"style.css", "text/css"}}};
+            auto it = files.find(req.path);
+            ifstream in;
+            if (it != files.end()) in.open(staticDir + "/" + it->second.first, ios::binary);
+            if (in.is_open()) {
+                resp.contentType = it->second.second;
+                resp.body.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+            } else {
+                resp.status = 404;
+                resp.body = "{\"status\":\"error\", \"msg\":\"Not found\"}";
+            }
+        } else {
+            resp.status = 404;
+            resp.body = "{\"status\":\"error\", \"msg\":\"Not found\"}";
+        }
+    }, workers);
+
+    if (!server.listen(host, port)) {
+        cerr << "Cannot listen on " << host << ":" << port << endl;
+        return;
+    }
+    activeHttpServer = &server;
+    signal(SIGINT, stopHttpServer);
+    signal(SIGTERM, stopHttpServer);
+    signal(SIGPIPE, SIG_IGN);
+
+    cout << "{\"status\":\"ready\", \"http\":" << port << ", \"workers\":" << workers << readyExtra << "}" << endl;
+    server.run();
+    activeHttpServer = nullptr;
+    ctx.publisher = nullptr;
+
+    if (ctx.wal) takeSnapshot(ctx);
+}
+#endif
+
 void runInteractiveMode(InventoryManager& inv, ProductCatalog& cat, OrderManager& om, WarehouseGraph& graph, ActionHistory& hist) {
     int choice;
     int orderCounter = 1;
@@ -279,19 +1044,21 @@ void runInteractiveMode(InventoryManager& inv, ProductCatalog& cat, OrderManager
                 cout << "Product Found: " << item->name << " (Available: " << item->quantity << ")\n";
                 cout << "Enter Quantity: ";
                 cin >> qty;
-                if (inv.hasStock(id, qty)) {
+                Item reserved;
+                if (inv.tryReserve(id, qty, &reserved)) { // Check and deduct stock
                     cout << "Enter Priority (1-10, 10=Highest): ";
                     cin >> prio;
                     
                     Order newOrder;
                     newOrder.id = orderCounter++;
-                    newOrder.itemName = item->name;
-                    newOrder.itemLocationNode = item->locationNode;
+                    newOrder.itemId = id;
+                    newOrder.itemName = reserved.name;
+                    newOrder.itemLocationNode = reserved.locationNode;
                     newOrder.quantity = qty;
                     newOrder.priority = prio;
 
+                    hist.logAction({ADD_ORDER, newOrder.id, id, qty, prio});
                     om.addOrder(newOrder);
-                    inv.updateStock(id, -qty); // Deduct stock
                     cout << ">>> Order Placed Successfully!\n";
                 } else {
                     cout << ">>> Error: Insufficient Stock!\n";
@@ -301,7 +1068,7 @@ void runInteractiveMode(InventoryManager& inv, ProductCatalog& cat, OrderManager
             }
         }
         else if (choice == 2) {
-            om.processNextOrder(graph);
+            om.processNextOrder(graph, inv);
         }
         else if (choice == 3) {
             om.dispatchNextOrder();
@@ -332,25 +1099,273 @@ void runInteractiveMode(InventoryManager& inv, ProductCatalog& cat, OrderManager
 }
 
 int main(int argc, char* argv[]) {
+    auto startTime = chrono::steady_clock::now();
+
     // Instantiate Core Components
     ActionHistory history;
+    ContractionHierarchy hierarchy; // Declared before the graph: it must outlive it
     WarehouseGraph graph;
     InventoryManager inventory;
     ProductCatalog catalog;
     OrderManager orderManager(&history);
 
-    // Setup Data
-    setupWarehouse(graph);
-    setupInventory(inventory);
-    setupCatalog(catalog);
+    // Versioned change log behind GET_STATE_SINCE
+    ChangeJournal journal;
+    StateSerializer serializer(&journal); // GET_STATE, with cached inventory/catalog fragments
+    inventory.setJournal(&journal);
+    catalog.setJournal(&journal);
+    orderManager.setJournal(&journal);
 
     bool apiMode = false;
-    if (argc > 1 && string(argv[1]) == "--api") {
-        apiMode = true;
+    bool pipelineMode = false;
+    size_t pipelineWorkers = 0; // 0 = one per core
+    string dataDir;             // Empty = no persistence
+    int walSyncMs = 5;          // Async group commit window: replies may be up to this far ahead of disk (0 = fsync every record)
+    size_t snapshotEvery = 10000;
+    string layoutFile, inventoryFile, catalogFile; // Empty = built-in demo data
+    size_t historyDepth = 0;    // Undo depth limit (0 = unlimited)
+    size_t landmarks = 0;       // ALT landmarks for point-to-point routing (0 = plain Dijkstra)
+    string hierarchyFile;       // Contraction-hierarchy index to map at startup
+    string buildHierarchyFile;  // Build an index for the layout, save it here and exit
+    string recordFile;          // --record: log API input for later replay
+    string replayFile;          // --replay: run a recorded stream instead of reading stdin
+    size_t syntheticCount = 0;  // --replay-synthetic N: generated stream instead
+    string mixSpec;
+    double replaySpeed = 0;     // 0 = flat out, 1 = recorded pace
+    double syntheticRate = 1000; // Commands/sec in the generated schedule
+    bool statsEnabled = true;   // Latency histograms behind STATS
+    bool binaryProtocol = false; // --binary: framed, pipelined API protocol on stdin/stdout
+    int httpPort = 0;           // --http: serve the API over HTTP instead of stdin (0 = off)
+    string httpHost = "127.0.0.1";
+    size_t httpWorkers = 0;     // 0 = one per core
+    string httpStatic;          // Directory holding index.html / script.js / style.css
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--api") {
+            apiMode = true;
+        } else if (arg == "--pipeline") {
+            pipelineMode = true;
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) {
+                pipelineWorkers = (size_t)atoi(argv[++i]);
+            }
+        } else if (arg == "--data-dir" && i + 1 < argc) {
+            dataDir = argv[++i];
+        } else if (arg == "--wal-sync-ms" && i + 1 < argc) {
+            walSyncMs = atoi(argv[++i]);
+        } else if (arg == "--snapshot-every" && i + 1 < argc) {
+            snapshotEvery = (size_t)atol(argv[++i]);
+        } else if (arg == "--http") {
+            httpPort = 3000;
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) httpPort = atoi(argv[++i]);
+            apiMode = true;
+        } else if (arg == "--http-host" && i + 1 < argc) {
+            httpHost = argv[++i];
+        } else if (arg == "--http-workers" && i + 1 < argc) {
+            httpWorkers = (size_t)atol(argv[++i]);
+        } else if (arg == "--http-static" && i + 1 < argc) {
+            httpStatic = argv[++i];
+        } else if (arg == "--binary") {
+            binaryProtocol = true;
+            apiMode = true;
+        } else if (arg == "--no-stats") {
+            statsEnabled = false;
+        } else if (arg == "--record" && i + 1 < argc) {
+            recordFile = argv[++i];
+        } else if (arg == "--replay" && i + 1 < argc) {
+            replayFile = argv[++i];
+            apiMode = true;
+        } else if (arg == "--replay-synthetic" && i + 1 < argc) {
+            syntheticCount = (size_t)atol(argv[++i]);
+            apiMode = true;
+        } else if (arg == "--mix" && i + 1 < argc) {
+            mixSpec = argv[++i];
+        } else if (arg == "--replay-speed" && i + 1 < argc) {
+            replaySpeed = atof(argv[++i]);
+        } else if (arg == "--replay-rate" && i + 1 < argc) {
+            syntheticRate = atof(argv[++i]);
+        } else if (arg == "--history-depth" && i + 1 < argc) {
+            historyDepth = (size_t)atol(argv[++i]);
+        } else if (arg == "--landmarks" && i + 1 < argc) {
+            landmarks = (size_t)atol(argv[++i]);
+        } else if (arg == "--ch" && i + 1 < argc) {
+            hierarchyFile = argv[++i];
+        } else if (arg == "--build-ch" && i + 1 < argc) {
+            buildHierarchyFile = argv[++i];
+        } else if (arg == "--layout" && i + 1 < argc) {
+            layoutFile = argv[++i];
+        } else if (arg == "--inventory" && i + 1 < argc) {
+            inventoryFile = argv[++i];
+        } else if (arg == "--catalog" && i + 1 < argc) {
+            catalogFile = argv[++i];
+        }
+    }
+
+    history.setMaxDepth(historyDepth);
+
+    // Setup Data. Load reports go to stderr so they never mix with API responses.
+    LoadReport layoutReport, inventoryReport, catalogReport;
+    if (layoutFile.empty()) {
+        setupWarehouse(graph);
+    } else if (loadLayoutFile(layoutFile, graph, layoutReport)) {
+        printLoadReport(layoutReport, cerr);
+    } else {
+        cerr << "Cannot read layout file " << layoutFile << endl;
+        return 1;
+    }
+    if (landmarks > 0) {
+        auto t0 = chrono::steady_clock::now();
+        graph.buildLandmarks(landmarks);
+        cerr << "Built " << graph.landmarkCount() << " landmarks (" << graph.landmarkBytes() / 1024 << " KB) in "
+             << chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count() << " ms" << endl;
+    }
+
+    // Offline step: contract the layout, save the index and stop
+    if (!buildHierarchyFile.empty()) {
+        auto t0 = chrono::steady_clock::now();
+        graph.buildHierarchy(hierarchy);
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+        if (!hierarchy.save(buildHierarchyFile)) {
+            cerr << "Cannot write " << buildHierarchyFile << endl;
+            return 1;
+        }
+        cerr << "Built contraction hierarchy: " << hierarchy.nodeCount() << " nodes, " << hierarchy.edgeCount()
+             << " upward edges (" << hierarchy.shortcutCount() << " shortcuts) in " << ms << " ms -> "
+             << buildHierarchyFile << endl;
+        return 0;
+    }
+    if (!hierarchyFile.empty()) {
+        if (!hierarchy.open(hierarchyFile)) {
+            cerr << "Cannot read contraction hierarchy " << hierarchyFile << "; routing without it" << endl;
+        } else if (!graph.attachHierarchy(&hierarchy)) {
+            cerr << "Contraction hierarchy " << hierarchyFile << " was built for a different layout; routing without it" << endl;
+        } else {
+            cerr << "Mapped contraction hierarchy " << hierarchyFile << " (" << hierarchy.nodeCount() << " nodes, "
+                 << hierarchy.edgeCount() << " edges)" << endl;
+        }
+    }
+
+    // With --data-dir, inventory/catalog/orders come from the last snapshot if there is one
+    string snapshotPath, walPath;
+    uint64_t snapshotLsn = 0;
+    int orderCounter = 1;
+    bool restored = false;
+    if (apiMode && !dataDir.empty()) {
+        snapshotPath = dataDir + "/warehouse.snap";
+        walPath = dataDir + "/warehouse.wal";
+        if (ifstream(snapshotPath).good()) {
+            if (!loadSnapshot(snapshotPath, snapshotLsn, orderCounter, inventory, catalog, orderManager, history)) {
+                cerr << "Snapshot " << snapshotPath << " is damaged; refusing to start" << endl;
+                return 1;
+            }
+            restored = true;
+        }
+    }
+    if (!restored) {
+        if (inventoryFile.empty()) {
+            setupInventory(inventory);
+        } else if (loadInventoryFile(inventoryFile, inventory, inventoryReport)) {
+            printLoadReport(inventoryReport, cerr);
+        } else {
+            cerr << "Cannot read inventory file " << inventoryFile << endl;
+            return 1;
+        }
+
+        if (catalogFile.empty()) {
+            setupCatalog(catalog);
+        } else if (loadCatalogFile(catalogFile, catalog, catalogReport)) {
+            printLoadReport(catalogReport, cerr);
+        } else {
+            cerr << "Cannot read catalog file " << catalogFile << endl;
+            return 1;
+        }
     }
 
     if (apiMode) {
-        runApiMode(inventory, catalog, orderManager, graph, history);
+        // Optional staged pipeline: routing runs on worker threads over the read-only graph
+        unique_ptr<OrderPipeline> pipeline;
+        PipelineOutbox outbox;
+        if (pipelineMode) {
+            if (pipelineWorkers == 0) pipelineWorkers = max(1u, thread::hardware_concurrency());
+            pipeline.reset(new OrderPipeline(graph, [&outbox](RoutedOrder& r) {
+                lock_guard<mutex> lk(outbox.lock);
+                outbox.orders.push_back(std::move(r));
+            }, pipelineWorkers));
+            pipeline->start();
+        }
+
+        ApiContext ctx{inventory, catalog, orderManager, graph, history, journal, serializer, orderCounter,
+                       pipeline.get(), &outbox, nullptr, snapshotPath, snapshotEvery};
+
+        string readyExtra;
+        WriteAheadLog wal;
+        if (!dataDir.empty()) {
+            // Replay whatever the log holds past the snapshot, then keep appending to it
+            vector<WalRecord> records;
+            size_t validBytes = 0;
+            WriteAheadLog::readAll(walPath, records, validBytes);
+            size_t replayed = replayWal(ctx, records, snapshotLsn);
+
+            uint64_t lastLsn = snapshotLsn;
+            if (!records.empty()) lastLsn = max(lastLsn, records.back().lsn);
+            if (!wal.open(walPath, walSyncMs, lastLsn + 1)) {
+                cerr << "Cannot open write-ahead log " << walPath << endl;
+                return 1;
+            }
+            ctx.wal = &wal;
+
+            double restartMs = chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+            readyExtra = ", \"restoredLsn\":" + to_string(snapshotLsn) +
+                         ", \"replayed\":" + to_string(replayed) +
+                         ", \"restartMs\":" + to_string(restartMs);
+        }
+
+        // After recovery, so the histograms only see live traffic
+        LatencyStats stats;
+        if (statsEnabled) {
+            ctx.stats = &stats;
+            graph.setStats(&stats);
+            orderManager.setStats(&stats);
+        }
+
+        if (!replayFile.empty() || syntheticCount > 0) {
+            vector<RecordedCommand> stream;
+            if (!replayFile.empty()) {
+                if (!loadCommandStream(replayFile, stream)) {
+                    cerr << "Cannot read command stream " << replayFile << endl;
+                    return 1;
+                }
+            } else {
+                vector<int> itemIds;
+                for (const Item& item : inventory.getInventory()) itemIds.push_back(item.id);
+                stream = generateCommandStream(syntheticCount, parseCommandMix(mixSpec), itemIds, syntheticRate, 42);
+            }
+            runReplayMode(ctx, stream, replaySpeed);
+        } else {
+            CommandRecorder recorder;
+            if (!recordFile.empty()) {
+                if (!recorder.open(recordFile)) {
+                    cerr << "Cannot open record file " << recordFile << endl;
+                    return 1;
+                }
+                ctx.recorder = &recorder;
+            }
+            if (httpPort > 0) {
+#ifdef __linux__
+                if (httpWorkers == 0) httpWorkers = max(1u, thread::hardware_concurrency());
+                runHttpMode(ctx, httpHost, httpPort, httpWorkers, httpStatic, readyExtra);
+#else
+                cerr << "--http needs Linux (epoll)" << endl;
+                return 1;
+#endif
+            } else if (binaryProtocol) {
+                runBinaryApiMode(ctx, readyExtra);
+            } else {
+                runApiMode(ctx, readyExtra);
+            }
+        }
+
+        if (pipeline) pipeline->shutdown();
+        wal.close();
     } else {
         runInteractiveMode(inventory, catalog, orderManager, graph, history);
     }
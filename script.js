@@ -25,6 +25,18 @@ let pendingOrders = [];
 let dispatchedOrders = [];
 let inventory = [];
 let catalog = [];
+
+// Delta sync: entities keyed by id, plus the backend version they reflect.
+// Versions restart with the backend; the epoch says which run they belong to.
+let stateVersion = null;
+let stateEpoch = null;
+const stateMaps = {
+    pending: new Map(),
+    dispatched: new Map(),
+    inventory: new Map(),
+    catalog: new Map()
+};
+const PENDING_ROWS = 50; // The dashboard only lists the first rows
 let activePath = [];
 
 function renderGraph() {
@@ -102,17 +114,39 @@ async function apiCall(command) {
     }
 }
 
+// Apply a full snapshot or a GET_STATE_SINCE delta to the local maps
+function applyState(data) {
+    Object.keys(stateMaps).forEach(key => {
+        const map = stateMaps[key];
+        if (data.full) {
+            map.clear();
+            (data[key] || []).forEach(e => map.set(e.id, e));
+        } else if (data[key]) {
+            (data[key].removed || []).forEach(id => map.delete(id));
+            (data[key].upsert || []).forEach(e => map.set(e.id, e));
+        }
+    });
+    stateVersion = data.version;
+    stateEpoch = data.epoch;
+
+    pendingOrders = [...stateMaps.pending.values()]
+        .sort((a, b) => b.prio - a.prio)
+        .slice(0, PENDING_ROWS);
+    dispatchedOrders = [...stateMaps.dispatched.values()];
+    inventory = [...stateMaps.inventory.values()];
+    catalog = [...stateMaps.catalog.values()].sort((a, b) => a.id - b.id);
+}
+
 async function fetchState() {
     try {
-        const res = await fetch('/api/state');
+        // First call gets a full snapshot, later calls only what changed
+        const url = stateVersion === null ? '/api/state' : `/api/state?since=${stateVersion}&epoch=${stateEpoch}`;
+        const res = await fetch(url);
         if (!res.ok) return;
         const data = await res.json();
 
         if (data.status === 'success') {
-            pendingOrders = data.pending || [];
-            dispatchedOrders = data.dispatched || [];
-            inventory = data.inventory || [];
-            catalog = data.catalog || [];
+            applyState(data);
             updateUI();
         }
     } catch (e) {
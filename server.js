@@ -107,7 +107,15 @@ app.post('/api/command', async (req, res) => {
 
 app.get('/api/state', async (req, res) => {
     try {
-        const response = await sendCommand("GET_STATE");
+        // Optional ?since=V&epoch=E asks for a delta since version V of run E,
+        // optional ?limit=N caps the pending list (full list when omitted)
+        const since = parseInt(req.query.since, 10);
+        const epoch = /^\d{1,18}$/.test(req.query.epoch || '') ? req.query.epoch : '';
+        const limit = parseInt(req.query.limit, 10);
+        let cmd = "GET_STATE";
+        if (Number.isInteger(since) && since >= 0) cmd = `GET_STATE_SINCE ${since} ${epoch}`.trim();
+        else if (Number.isInteger(limit) && limit >= 0) cmd = `GET_STATE ${limit}`;
+        const response = await sendCommand(cmd);
         res.json(response);
     } catch (error) {
         res.status(500).json({ error: error.message });